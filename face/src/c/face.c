@@ -0,0 +1,195 @@
+#include <pebble.h>
+#include "types.h"
+#include "fields.h"
+#include "next.h"
+
+// Final rectangles for this platform, generated from the app's src/layout.json
+#include "src/layout_table.auto.h"
+
+// Watchface: the time, the date, and how long until the next dawn, sunrise,
+// sunset or dusk. Wakes once a minute and works from two days of integer
+// minutes computed on the watch; the phone is only asked for a location
+// when the last one has gone stale.
+
+#define FACE_FIELDS SOLAR_FIELDS_CLASSIC
+
+#define FIX_MAX_AGE_S (6 * SECONDS_PER_HOUR)      // four phone round trips a day at most
+#define FIX_RETRY_S   (30 * SECONDS_PER_MINUTE)   // between asks while a fix is overdue
+
+#define PERSIST_KEY_FIX 1
+
+typedef struct {
+  SolarLocation loc;
+  int32_t fixed_at;     // UTC seconds the phone sent it
+} FaceFix;
+
+static Window *s_window;
+static Layer *s_content_layer;
+static TextLayer *s_date_layer;
+static TextLayer *s_clock_layer;
+static TextLayer *s_label_layer;
+static TextLayer *s_countdown_layer;
+
+static FaceFix s_fix;
+static bool s_have_fix = false;
+static time_t s_asked_at = 0;
+
+// Today and tomorrow at the fix; recomputed when either changes
+static DayTimes s_days[2];
+
+// What each layer shows. A layer is only handed new text (and so only
+// redrawn) when its string actually changes.
+static char s_date_buf[20];
+static char s_clock_buf[8];
+static char s_label_buf[12];
+static char s_countdown_buf[8];
+
+static void prv_set_text(TextLayer *layer, char *buf, size_t size, const char *text) {
+  if (!strncmp(buf, text, size)) return;
+  strncpy(buf, text, size - 1);
+  buf[size - 1] = 0;
+  text_layer_set_text(layer, buf);
+}
+
+static void prv_ask_phone(time_t now) {
+  if (s_have_fix && now - s_fix.fixed_at < FIX_MAX_AGE_S) return;
+  if (s_asked_at && now - s_asked_at < FIX_RETRY_S) return;
+  if (!connection_service_peek_pebble_app_connection()) return;
+
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) return;
+  dict_write_uint8(iter, MESSAGE_KEY_REQ, 1);
+  if (app_message_outbox_send() == APP_MSG_OK) s_asked_at = now;
+}
+
+static void prv_update(time_t now) {
+  char buf[20];
+  clock_copy_time_string(buf, sizeof(buf));
+  prv_set_text(s_clock_layer, s_clock_buf, sizeof(s_clock_buf), buf);
+  strftime(buf, sizeof(buf), "%a %b %d", localtime(&now));
+  prv_set_text(s_date_layer, s_date_buf, sizeof(s_date_buf), buf);
+
+  const char *label = "";
+  strcpy(buf, "--:--");
+  if (s_have_fix) {
+    int32_t today = solar_local_day(&s_fix.loc, now);
+    if (!s_days[0].valid || s_days[0].day != today) {
+      for (int d = 0; d < 2; d++) {
+        s_days[d].valid = true;
+        s_days[d].day = today + d;
+        solar_compute_day(&s_fix.loc, FACE_FIELDS, today + d, &s_days[d].times);
+      }
+    }
+    // The clock on screen is in the watch's zone now, whatever it was at the fix
+    int16_t minute = (int16_t)((now + localtime(&now)->tm_gmtoff - (time_t)today * SECONDS_PER_DAY) / 60);
+    NextEvent next;
+    if (next_event(s_days, FACE_FIELDS, minute, &next)) {
+      label = fields_label(next.field);
+      snprintf(buf, sizeof(buf), "%d:%02d", next.in_minutes / 60, next.in_minutes % 60);
+    }
+  }
+  prv_set_text(s_label_layer, s_label_buf, sizeof(s_label_buf), label);
+  prv_set_text(s_countdown_layer, s_countdown_buf, sizeof(s_countdown_buf), buf);
+}
+
+static void prv_minute_tick(struct tm *tick_time, TimeUnits units_changed) {
+  time_t now = time(NULL);
+  prv_update(now);
+  prv_ask_phone(now);
+}
+
+static void prv_inbox_received(DictionaryIterator *iter, void *context) {
+  // The phone side just started: a good moment to ask if the fix is overdue
+  if (dict_find(iter, MESSAGE_KEY_HELLO)) {
+    s_asked_at = 0;
+    prv_ask_phone(time(NULL));
+    return;
+  }
+
+  Tuple *lat_t = dict_find(iter, MESSAGE_KEY_LAT);
+  Tuple *lon_t = dict_find(iter, MESSAGE_KEY_LON);
+  Tuple *utc_t = dict_find(iter, MESSAGE_KEY_UTC_OFFSET);
+  if (!lat_t || !lon_t || !utc_t) return;
+
+  s_fix = (FaceFix) {
+    .loc = {
+      .lat_e6 = lat_t->value->int32,
+      .lon_e6 = lon_t->value->int32,
+      .utc_offset = utc_t->value->int32,
+      .zone_change = SOLAR_ZONE_WATCH,
+    },
+    .fixed_at = time(NULL),
+  };
+  s_have_fix = true;
+  s_days[0].valid = false;
+  persist_write_data(PERSIST_KEY_FIX, &s_fix, sizeof(s_fix));
+  prv_update(time(NULL));
+}
+
+static TextLayer *prv_text_layer(Layer *parent, GRect frame, const char *font, GTextAlignment align) {
+  TextLayer *layer = text_layer_create(frame);
+  text_layer_set_background_color(layer, GColorClear);
+  text_layer_set_text_color(layer, GColorWhite);
+  text_layer_set_font(layer, fonts_get_system_font(font));
+  text_layer_set_text_alignment(layer, align);
+  layer_add_child(parent, text_layer_get_layer(layer));
+  return layer;
+}
+
+static void prv_window_load(Window *window) {
+  s_content_layer = layer_create(LAYOUT_CONTENT);
+  layer_add_child(window_get_root_layer(window), s_content_layer);
+
+  // Same rectangles as the app: date on top, the clock over the rows above
+  // the last, and the countdown in the last row
+  GTextAlignment align = PBL_IF_ROUND_ELSE(GTextAlignmentCenter, GTextAlignmentLeft);
+  int16_t clock_y = LAYOUT_TIME[0].origin.y;
+  GRect clock = GRect(0, clock_y, LAYOUT_CONTENT.size.w, LAYOUT_TIME[LAYOUT_ROWS - 1].origin.y - clock_y);
+
+  s_date_layer = prv_text_layer(s_content_layer, LAYOUT_DATE, LAYOUT_FONT_DATE, align);
+  s_clock_layer = prv_text_layer(s_content_layer, clock, FONT_KEY_LECO_36_BOLD_NUMBERS, align);
+  s_label_layer = prv_text_layer(s_content_layer, LAYOUT_LABEL[LAYOUT_ROWS - 1], LAYOUT_FONT_LABELS, GTextAlignmentLeft);
+  s_countdown_layer = prv_text_layer(s_content_layer, LAYOUT_TIME[LAYOUT_ROWS - 1], LAYOUT_FONT_TIMES, GTextAlignmentLeft);
+}
+
+static void prv_window_unload(Window *window) {
+  text_layer_destroy(s_countdown_layer);
+  text_layer_destroy(s_label_layer);
+  text_layer_destroy(s_clock_layer);
+  text_layer_destroy(s_date_layer);
+  layer_destroy(s_content_layer);
+}
+
+static void init(void) {
+  s_have_fix = persist_read_data(PERSIST_KEY_FIX, &s_fix, sizeof(s_fix)) == (int)sizeof(s_fix);
+
+  s_window = window_create();
+  window_set_background_color(s_window, GColorBlack);
+  window_set_window_handlers(s_window, (WindowHandlers) {
+    .load = prv_window_load,
+    .unload = prv_window_unload,
+  });
+  window_stack_push(s_window, false);
+
+  // Three int32 tuples in, one flag out
+  app_message_register_inbox_received(prv_inbox_received);
+  app_message_open(dict_calc_buffer_size(3, sizeof(int32_t), sizeof(int32_t), sizeof(int32_t)),
+                   dict_calc_buffer_size(1, sizeof(uint8_t)));
+
+  time_t now = time(NULL);
+  prv_update(now);
+  prv_ask_phone(now);
+  tick_timer_service_subscribe(MINUTE_UNIT, prv_minute_tick);
+}
+
+static void deinit(void) {
+  tick_timer_service_unsubscribe();
+  app_message_deregister_callbacks();
+  window_destroy(s_window);
+}
+
+int main(void) {
+  init();
+  app_event_loop();
+  deinit();
+}
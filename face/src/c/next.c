@@ -0,0 +1,23 @@
+#include <pebble.h>
+#include "next.h"
+
+bool next_event(const DayTimes days[2], SolarFields fields, int16_t minute, NextEvent *out) {
+  int best = INT16_MAX;
+  for (int d = 0; d < 2; d++) {
+    if (!days[d].valid) continue;
+    uint8_t slot = 0;
+    for (int f = 0; f < SOLAR_FIELD_COUNT && slot < SOLAR_MAX_FIELDS; f++) {
+      if (!(fields & SOLAR_FIELD(f))) continue;
+      int16_t m = days[d].times.minutes[slot++];
+      if (m == SOLAR_NONE) continue;
+      // Field order is not time order once an event wraps past midnight
+      int in = d * 1440 + m - minute;
+      if (in <= 0 || in >= best) continue;
+      best = in;
+      out->field = f;
+    }
+  }
+  if (best == INT16_MAX) return false;
+  out->in_minutes = best;
+  return true;
+}
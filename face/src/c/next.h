@@ -0,0 +1,14 @@
+#pragma once
+#include <pebble.h>
+#include "types.h"
+
+// The soonest event still ahead, worked out from the cached minutes alone
+typedef struct {
+  SolarField field;
+  int16_t in_minutes;   // from now until the event, > 0
+} NextEvent;
+
+// Search today and tomorrow (days[0] and the day after it, both holding
+// `fields`) for the first event after `minute` of today. False if neither
+// day has one left, e.g. through polar day or night.
+bool next_event(const DayTimes days[2], SolarFields fields, int16_t minute, NextEvent *out);
@@ -0,0 +1,54 @@
+// Phone side of the Helios watchface. The face computes everything itself;
+// all it ever asks for is where it is, a few times a day at most.
+
+var FIX_KEY = 'helios-face-fix';
+var FIX_MAX_AGE_MS = 6 * 60 * 60 * 1000;   // matches FIX_MAX_AGE_S on the watch
+
+function loadFix() {
+  try {
+    var fix = JSON.parse(localStorage.getItem(FIX_KEY));
+    return fix && typeof fix.lat === 'number' && typeof fix.lon === 'number' ? fix : null;
+  } catch (e) {
+    return null;
+  }
+}
+
+function sendFix(fix) {
+  Pebble.sendAppMessage({
+    LAT: Math.round(fix.lat * 1e6),
+    LON: Math.round(fix.lon * 1e6),
+    UTC_OFFSET: -new Date().getTimezoneOffset() * 60
+  }, null, function() {
+    console.log('Fix not delivered; the face asks again later');
+  });
+}
+
+function answer() {
+  var last = loadFix();
+  if (!navigator.geolocation || !navigator.geolocation.getCurrentPosition) {
+    if (last) sendFix(last);
+    return;
+  }
+  navigator.geolocation.getCurrentPosition(function(pos) {
+    var fix = { lat: pos.coords.latitude, lon: pos.coords.longitude };
+    localStorage.setItem(FIX_KEY, JSON.stringify(fix));
+    sendFix(fix);
+  }, function(err) {
+    console.log('Geolocation error: ' + JSON.stringify(err));
+    // Yesterday's location still beats no countdown at all
+    if (last) sendFix(last);
+  }, {
+    enableHighAccuracy: false,
+    maximumAge: FIX_MAX_AGE_MS,
+    timeout: 30000
+  });
+}
+
+Pebble.addEventListener('ready', function() {
+  Pebble.sendAppMessage({ HELLO: 1 });
+});
+
+Pebble.addEventListener('appmessage', function(e) {
+  var p = (e && e.payload) || {};
+  if (p.REQ) answer();
+});
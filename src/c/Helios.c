@@ -1,6 +1,10 @@
 #include <pebble.h>
 #include "ui.h"
 #include "msg.h"
+#include "chart.h"
+#include "scenario.h"
+#include "probe.h"
+#include "lowmem.h"
 
 static Window *s_main_window;
 
@@ -11,14 +15,21 @@ static void up_click_handler(ClickRecognizerRef recognizer, void *ctx) {
 static void down_click_handler(ClickRecognizerRef recognizer, void *ctx) {
   msg_navigate_to_offset(msg_get_day_offset() + 1);
 }
+// Select jumps back to today, and from today opens the year chart. A
+// multi-click here would hold every Select press for the multi-click timeout.
 static void select_click_handler(ClickRecognizerRef recognizer, void *ctx) {
-  msg_navigate_to_offset(0);
+  if (msg_get_day_offset() != 0) msg_navigate_to_offset(0);
+  else chart_push();
+}
+static void select_long_click_handler(ClickRecognizerRef recognizer, void *ctx) {
+  msg_cycle_place();
 }
 
 static void click_config_provider(void *ctx) {
   window_single_click_subscribe(BUTTON_ID_UP, up_click_handler);
   window_single_click_subscribe(BUTTON_ID_DOWN, down_click_handler);
   window_single_click_subscribe(BUTTON_ID_SELECT, select_click_handler);
+  window_long_click_subscribe(BUTTON_ID_SELECT, 0, select_long_click_handler, NULL);
 
   // Optional: hold to scroll faster
   window_single_repeating_click_subscribe(BUTTON_ID_UP, 180, up_click_handler);
@@ -30,7 +41,24 @@ static void phone_conn_handler(bool connected) {
   msg_on_phone_conn_changed(connected);
 }
 
+#ifdef HELIOS_PROBES
+// Probe builds: a wrist flick opens the overlay, leaving the buttons alone
+static void probe_tap_handler(AccelAxisType axis, int32_t direction) {
+  probe_show_overlay();
+}
+#endif
+
+// Tick service: only the date matters
+static void day_tick_handler(struct tm *tick_time, TimeUnits units_changed) {
+  msg_on_day_changed();
+}
+
 static void init(void) {
+  lowmem_init();
+#ifdef HELIOS_PROBES
+  probe_init();
+  accel_tap_service_subscribe(probe_tap_handler);
+#endif
   s_main_window = window_create();
   window_set_background_color(s_main_window, GColorBlack);
   window_set_click_config_provider(s_main_window, click_config_provider);
@@ -40,17 +68,30 @@ static void init(void) {
 
   msg_init();
 
+  // Keeps the stored week current between launches (worker_src/), when opted in
+  msg_start_worker();
+
   connection_service_subscribe((ConnectionHandlers) {
     .pebble_app_connection_handler = phone_conn_handler
   });
   phone_conn_handler(connection_service_peek_pebble_app_connection());
+
+  tick_timer_service_subscribe(DAY_UNIT, day_tick_handler);
+
+  scenario_start();
 }
 
 static void deinit(void) {
+  scenario_stop();
+  tick_timer_service_unsubscribe();
   connection_service_unsubscribe();
 
   msg_deinit();
   ui_deinit();
+#ifdef HELIOS_PROBES
+  accel_tap_service_unsubscribe();
+  probe_deinit();
+#endif
 
   window_destroy(s_main_window);
   s_main_window = NULL;
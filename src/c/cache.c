@@ -0,0 +1,150 @@
+#include <pebble.h>
+#include "cache.h"
+
+// Ring of s_width (up to CACHE_DAYS) entries. s_head is the slot holding day
+// s_first; sliding the window moves s_head and only invalidates the slots
+// that wrap around.
+static DayTimes s_ring[CACHE_DAYS];
+static uint8_t s_width = CACHE_DAYS;
+static uint8_t s_head = 0;
+static int32_t s_first = 0;
+static int32_t s_cursor = 0;
+static int8_t s_direction = 0;   // -1 up (earlier), +1 down (later), 0 unknown
+static CacheStats s_stats;
+
+static DayTimes *prv_slot(int32_t day) {
+  int32_t idx = day - s_first;
+  if (idx < 0 || idx >= s_width) return NULL;
+  return &s_ring[(s_head + idx) % s_width];
+}
+
+static void prv_slide_to(int32_t first) {
+  int32_t shift = first - s_first;
+  if (shift == 0) return;
+
+  if (shift >= s_width || shift <= -s_width) {
+    for (int i = 0; i < s_width; i++) s_ring[i].valid = false;
+    s_head = 0;
+  } else if (shift > 0) {
+    // Drop the oldest `shift` days; their slots become the new tail end
+    for (int32_t i = 0; i < shift; i++) {
+      s_ring[(s_head + i) % s_width].valid = false;
+    }
+    s_head = (s_head + shift) % s_width;
+  } else {
+    // Drop the newest days; their slots become the new front
+    for (int32_t i = 0; i < -shift; i++) {
+      s_head = (s_head + s_width - 1) % s_width;
+      s_ring[s_head].valid = false;
+    }
+  }
+  s_first = first;
+}
+
+static int32_t prv_window_first_for(int32_t cursor, int8_t direction) {
+  if (direction > 0) return cursor - CACHE_TAIL;
+  if (direction < 0) return cursor - (s_width - 1 - CACHE_TAIL);
+  return cursor - s_width / 2;
+}
+
+void cache_clear(void) {
+  for (int i = 0; i < s_width; i++) s_ring[i].valid = false;
+  s_head = 0;
+  s_direction = 0;
+  s_first = prv_window_first_for(s_cursor, 0);
+}
+
+void cache_set_width(uint8_t days) {
+  if (days > CACHE_DAYS) days = CACHE_DAYS;
+  if (days <= CACHE_TAIL) days = CACHE_TAIL + 1;
+  s_width = days;
+  cache_clear();
+}
+
+uint8_t cache_width(void) {
+  return s_width;
+}
+
+void cache_set_cursor(int32_t day) {
+  if (day > s_cursor) s_direction = 1;
+  else if (day < s_cursor) s_direction = -1;
+  cache_jump_to(day);
+}
+
+void cache_jump_to(int32_t day) {
+  s_cursor = day;
+  prv_slide_to(prv_window_first_for(s_cursor, s_direction));
+}
+
+DayTimes *cache_get(int32_t day) {
+  DayTimes *dt = prv_slot(day);
+  if (dt && dt->valid) {
+    s_stats.hits++;
+    return dt;
+  }
+  s_stats.misses++;
+  return NULL;
+}
+
+bool cache_has(int32_t day) {
+  DayTimes *dt = prv_slot(day);
+  return dt && dt->valid;
+}
+
+DayTimes *cache_put(int32_t day, const SolarDay *times) {
+  DayTimes *dt = prv_slot(day);
+  if (!dt) return NULL;
+  dt->valid = true;
+  dt->day = day;
+  dt->times = *times;
+  return dt;
+}
+
+void cache_keep_range(int32_t first, uint8_t count) {
+  for (int i = 0; i < s_width; i++) {
+    DayTimes *dt = &s_ring[i];
+    if (dt->valid && (dt->day < first || dt->day >= first + count)) dt->valid = false;
+  }
+}
+
+static void prv_shift(int16_t *minute, int16_t by) {
+  if (*minute == SOLAR_NONE) return;
+  *minute = (*minute + by + 2 * 24 * 60) % (24 * 60);
+}
+
+void cache_shift_minutes(int16_t minutes) {
+  for (int i = 0; i < s_width; i++) {
+    if (!s_ring[i].valid) continue;
+    for (int f = 0; f < SOLAR_MAX_FIELDS; f++) prv_shift(&s_ring[i].times.minutes[f], minutes);
+  }
+}
+
+bool cache_next_missing(int32_t *day) {
+  int8_t ahead = s_direction < 0 ? -1 : 1;
+  // Alternate outward from the cursor, always favouring the direction of travel
+  for (int32_t step = 0; step < s_width; step++) {
+    int32_t candidates[2] = { s_cursor + ahead * step, s_cursor - ahead * (step + 1) };
+    for (int i = 0; i < 2; i++) {
+      DayTimes *dt = prv_slot(candidates[i]);
+      if (dt && !dt->valid) {
+        *day = candidates[i];
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+int32_t cache_window_first(void) {
+  return s_first;
+}
+
+DayTimes *cache_at(uint8_t index) {
+  if (index >= s_width) return NULL;
+  DayTimes *dt = &s_ring[(s_head + index) % s_width];
+  return dt->valid ? dt : NULL;
+}
+
+const CacheStats *cache_get_stats(void) {
+  return &s_stats;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <pebble.h>
+#include "types.h"
+
+// Widest window in days. Small where RAM is tight; every width fits one store record.
+#if defined(PBL_PLATFORM_APLITE)
+  #define CACHE_DAYS 7
+#elif defined(PBL_PLATFORM_EMERY)
+  #define CACHE_DAYS 21
+#else
+  #define CACHE_DAYS 14
+#endif
+
+// Window in the low-memory profile (lowmem.h): the tail, the cursor and two ahead
+#define CACHE_DAYS_LOW 5
+
+// Days kept behind the cursor while scrolling; the rest of the window is ahead of it
+#define CACHE_TAIL 2
+
+typedef struct {
+  uint32_t hits;
+  uint32_t misses;
+} CacheStats;
+
+// Entries are keyed by absolute local day (days since 1970-01-01), so they stay
+// put when "today" moves on at midnight.
+
+void cache_clear(void);
+
+// Days the window spans, at most CACHE_DAYS. Clears the cache.
+void cache_set_width(uint8_t days);
+uint8_t cache_width(void);
+
+// Move the cursor. The window follows it, leaning towards the direction of travel.
+void cache_set_cursor(int32_t day);
+
+// Move the cursor without implying a direction (start-up, midnight rollover)
+void cache_jump_to(int32_t day);
+
+// Entry for a day if it is cached; counts towards the hit/miss stats
+DayTimes *cache_get(int32_t day);
+
+// Same lookup without touching the stats
+bool cache_has(int32_t day);
+
+// Store a day. Days outside the current window are ignored.
+DayTimes *cache_put(int32_t day, const SolarDay *times);
+
+// Forget every cached day outside [first, first + count)
+void cache_keep_range(int32_t first, uint8_t count);
+
+// Move every cached event by the same number of minutes, wrapping at midnight
+void cache_shift_minutes(int16_t minutes);
+
+// Next uncached day in the window, nearest the cursor and ahead of it first
+bool cache_next_missing(int32_t *day);
+
+// First day of the window, for asking the phone to fill it
+int32_t cache_window_first(void);
+
+// Walk the window in order; returns NULL for uncached slots
+DayTimes *cache_at(uint8_t index);
+
+const CacheStats *cache_get_stats(void);
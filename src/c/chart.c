@@ -0,0 +1,247 @@
+#include <pebble.h>
+#include "chart.h"
+#include "msg.h"
+#include "year.h"
+
+#define CHART_HEADER_H   20
+#define CHART_TICK_H     3
+#define CHART_REPEAT_MS  60
+
+static Window *s_window;
+static Layer *s_plot_layer;
+static TextLayer *s_header_layer;
+static char s_header_buf[40];
+
+static uint16_t s_cursor = 0;       // index into the year
+static uint16_t s_month_start[12];  // index of the 1st of each month
+
+// Colours: daylight columns and the two curves. On black and white the
+// daylight is a 50% dither, so the curves and the cursor still show on it.
+#ifdef PBL_COLOR
+  #define COLOR_DAYLIGHT GColorOxfordBlue
+  #define COLOR_RISE     GColorChromeYellow
+  #define COLOR_SET      GColorOrange
+#else
+  #define COLOR_DAYLIGHT GColorWhite
+  #define COLOR_RISE     GColorWhite
+  #define COLOR_SET      GColorWhite
+#endif
+
+// Days with neither sunrise nor sunset that are midnight sun, one bit per
+// day, worked out whenever days land rather than on every redraw
+static uint8_t s_polar_day[(YEAR_MAX_DAYS + 7) / 8];
+
+static bool prv_is_leap(int year) {
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static bool prv_polar_day(uint16_t index) {
+  return s_polar_day[index / 8] & (1 << (index % 8));
+}
+
+static bool prv_has_both(const YearTable *t, int32_t i) {
+  return year_has(i) && t->rise[i] != SOLAR_NONE && t->set[i] != SOLAR_NONE;
+}
+
+// Sunrise/sunset missing both ways: up all day or down all day. The wire has
+// no flag for which, so each run of such days follows the nearest day on
+// either side that has both; a year that starts or ends inside the polar day
+// or night has one on the other side.
+static void prv_classify_polar(void) {
+  const YearTable *t = year_table();
+  memset(s_polar_day, 0, sizeof(s_polar_day));
+  if (!t) return;
+
+  int32_t i = 0;
+  while (i < t->count) {
+    if (prv_has_both(t, i)) {
+      i++;
+      continue;
+    }
+    int32_t start = i;
+    while (i < t->count && !prv_has_both(t, i)) i++;
+    // Days start..i-1; the first half takes after start-1, the rest after i
+    bool before = start > 0 && t->set[start - 1] - t->rise[start - 1] > 12 * 60;
+    bool after = i < t->count && t->set[i] - t->rise[i] > 12 * 60;
+    if (start == 0) before = after;
+    if (i == t->count) after = before;
+    int32_t mid = (start + i) / 2;
+    for (int32_t d = start; d < i; d++) {
+      if (d < mid ? before : after) s_polar_day[d / 8] |= 1 << (d % 8);
+    }
+  }
+}
+
+static int16_t prv_day_length(const YearTable *t, uint16_t index) {
+  if (t->rise[index] != SOLAR_NONE && t->set[index] != SOLAR_NONE) {
+    return t->set[index] - t->rise[index];
+  }
+  return prv_polar_day(index) ? 24 * 60 : 0;
+}
+
+static void prv_update_header(void) {
+  const YearTable *t = year_table();
+  if (!t) return;
+
+  time_t noon = (time_t)(t->first_day + s_cursor) * SECONDS_PER_DAY + SECONDS_PER_DAY / 2;
+  int n = strftime(s_header_buf, sizeof(s_header_buf), "%b %d ", gmtime(&noon));
+  if (!year_has(s_cursor)) {
+    snprintf(s_header_buf + n, sizeof(s_header_buf) - n, "%d%%", t->received * 100 / t->count);
+  } else {
+    int16_t len = prv_day_length(t, s_cursor);
+    snprintf(s_header_buf + n, sizeof(s_header_buf) - n, "%dh%02d", len / 60, len % 60);
+  }
+  text_layer_set_text(s_header_layer, s_header_buf);
+}
+
+static void prv_plot_update_proc(Layer *layer, GContext *ctx) {
+  const YearTable *t = year_table();
+  if (!t) return;
+
+  GRect b = layer_get_bounds(layer);
+  int16_t plot_h = b.size.h - CHART_TICK_H;
+  #define Y_OF(minute) ((int16_t)((int32_t)(minute) * plot_h / (24 * 60)))
+
+  // 06:00 / 12:00 / 18:00 guides
+  graphics_context_set_stroke_color(ctx, PBL_IF_COLOR_ELSE(GColorDarkGray, GColorWhite));
+  for (int h = 6; h < 24; h += 6) {
+    for (int16_t x = 0; x < b.size.w; x += 4) graphics_draw_pixel(ctx, GPoint(x, Y_OF(h * 60)));
+  }
+
+  // One column per pixel; columns whose day has not arrived yet stay empty
+  for (int16_t x = 0; x < b.size.w; x++) {
+    uint16_t i = (uint16_t)((int32_t)x * t->count / b.size.w);
+    if (!year_has(i)) continue;
+
+    int16_t rise = t->rise[i], set = t->set[i];
+    if (rise == SOLAR_NONE || set == SOLAR_NONE) {
+      if (!prv_polar_day(i)) continue;
+      // Midnight sun: daylight edge to edge
+      rise = 0;
+      set = 24 * 60 - 1;
+    }
+    graphics_context_set_stroke_color(ctx, COLOR_DAYLIGHT);
+    #ifdef PBL_COLOR
+      graphics_draw_line(ctx, GPoint(x, Y_OF(rise)), GPoint(x, Y_OF(set)));
+    #else
+      for (int16_t y = Y_OF(rise) + ((x + Y_OF(rise)) & 1); y <= Y_OF(set); y += 2) {
+        graphics_draw_pixel(ctx, GPoint(x, y));
+      }
+    #endif
+    graphics_context_set_stroke_color(ctx, COLOR_RISE);
+    graphics_draw_pixel(ctx, GPoint(x, Y_OF(rise)));
+    graphics_context_set_stroke_color(ctx, COLOR_SET);
+    graphics_draw_pixel(ctx, GPoint(x, Y_OF(set)));
+  }
+
+  // Month ticks along the bottom
+  graphics_context_set_stroke_color(ctx, GColorWhite);
+  for (int m = 0; m < 12; m++) {
+    int16_t x = (int16_t)((int32_t)s_month_start[m] * b.size.w / t->count);
+    graphics_draw_line(ctx, GPoint(x, plot_h), GPoint(x, b.size.h - 1));
+  }
+
+  // Cursor
+  int16_t cx = (int16_t)(((int32_t)s_cursor * b.size.w + b.size.w / 2) / t->count);
+  graphics_context_set_stroke_color(ctx, GColorWhite);
+  graphics_draw_line(ctx, GPoint(cx, 0), GPoint(cx, plot_h - 1));
+  #undef Y_OF
+}
+
+static void prv_on_update(void) {
+  prv_classify_polar();
+  if (s_plot_layer) layer_mark_dirty(s_plot_layer);
+  prv_update_header();
+}
+
+static void prv_move(int16_t delta) {
+  const YearTable *t = year_table();
+  if (!t) return;
+  int32_t c = (int32_t)s_cursor + delta;
+  if (c < 0) c = t->count - 1;
+  if (c >= t->count) c = 0;
+  s_cursor = (uint16_t)c;
+  layer_mark_dirty(s_plot_layer);
+  prv_update_header();
+}
+
+static void prv_up_click(ClickRecognizerRef recognizer, void *ctx) {
+  prv_move(-1);
+}
+
+static void prv_down_click(ClickRecognizerRef recognizer, void *ctx) {
+  prv_move(1);
+}
+
+static void prv_select_click(ClickRecognizerRef recognizer, void *ctx) {
+  const YearTable *t = year_table();
+  if (!t) return;
+  msg_navigate_to_offset(t->first_day + s_cursor - msg_get_today());
+  window_stack_pop(true);
+}
+
+static void prv_click_config(void *ctx) {
+  window_single_repeating_click_subscribe(BUTTON_ID_UP, CHART_REPEAT_MS, prv_up_click);
+  window_single_repeating_click_subscribe(BUTTON_ID_DOWN, CHART_REPEAT_MS, prv_down_click);
+  window_single_click_subscribe(BUTTON_ID_SELECT, prv_select_click);
+}
+
+static void prv_window_load(Window *window) {
+  Layer *root = window_get_root_layer(window);
+  GRect bounds = layer_get_bounds(root);
+
+  // Current calendar year, cursor on the day shown in the main view
+  int32_t shown = msg_get_today() + msg_get_day_offset();
+  time_t noon = (time_t)shown * SECONDS_PER_DAY + SECONDS_PER_DAY / 2;
+  struct tm *tm = gmtime(&noon);
+  int year = tm->tm_year + 1900;
+  s_cursor = tm->tm_yday;
+
+  static const uint16_t MONTH_START[12] = { 0, 31, 59, 90, 120, 151, 181, 212, 243, 273, 304, 334 };
+  bool leap = prv_is_leap(year);
+  for (int m = 0; m < 12; m++) s_month_start[m] = MONTH_START[m] + (leap && m >= 2);
+
+  s_header_layer = text_layer_create(GRect(0, 0, bounds.size.w, CHART_HEADER_H));
+  text_layer_set_background_color(s_header_layer, GColorBlack);
+  text_layer_set_text_color(s_header_layer, GColorWhite);
+  text_layer_set_font(s_header_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14_BOLD));
+  text_layer_set_text_alignment(s_header_layer, GTextAlignmentCenter);
+  layer_add_child(root, text_layer_get_layer(s_header_layer));
+
+  GRect plot = GRect(0, CHART_HEADER_H, bounds.size.w, bounds.size.h - CHART_HEADER_H);
+  #if defined(PBL_ROUND)
+    plot = grect_inset(plot, GEdgeInsets(0, 18, 18, 18));
+  #endif
+  s_plot_layer = layer_create(plot);
+  layer_set_update_proc(s_plot_layer, prv_plot_update_proc);
+  layer_add_child(root, s_plot_layer);
+
+  if (!msg_open_year(shown - tm->tm_yday, leap ? 366 : 365, prv_on_update)) {
+    text_layer_set_text(s_header_layer, "Out of memory");
+    return;
+  }
+  prv_classify_polar();
+  prv_update_header();
+}
+
+static void prv_window_unload(Window *window) {
+  msg_close_year();
+  layer_destroy(s_plot_layer);
+  s_plot_layer = NULL;
+  text_layer_destroy(s_header_layer);
+  s_header_layer = NULL;
+  window_destroy(s_window);
+  s_window = NULL;
+}
+
+void chart_push(void) {
+  if (s_window) return;
+  s_window = window_create();
+  window_set_background_color(s_window, GColorBlack);
+  window_set_click_config_provider(s_window, prv_click_config);
+  window_set_window_handlers(s_window, (WindowHandlers) {
+    .load = prv_window_load,
+    .unload = prv_window_unload,
+  });
+  window_stack_push(s_window, true);
+}
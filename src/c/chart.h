@@ -0,0 +1,6 @@
+#pragma once
+#include <pebble.h>
+
+// Year-at-a-glance view: daylight per day for the current calendar year,
+// with a cursor that can be moved to any day and opened in the main view
+void chart_push(void);
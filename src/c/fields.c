@@ -0,0 +1,54 @@
+#include <pebble.h>
+#include "fields.h"
+#include "store.h"
+
+static SolarFields s_fields = SOLAR_FIELDS_CLASSIC;
+
+static const char *LABELS[SOLAR_FIELD_COUNT] = {
+  [SOLAR_ASTRO_DAWN]    = "Astro",
+  [SOLAR_NAUTICAL_DAWN] = "Naut.",
+  [SOLAR_DAWN]          = "Dawn",
+  [SOLAR_BLUE_END]      = "Blue end",
+  [SOLAR_SUNRISE]       = "Sunrise",
+  [SOLAR_GOLDEN_END]    = "Gold end",
+  [SOLAR_NOON]          = "Noon",
+  [SOLAR_GOLDEN_START]  = "Golden",
+  [SOLAR_SUNSET]        = "Sunset",
+  [SOLAR_BLUE_START]    = "Blue",
+  [SOLAR_DUSK]          = "Dusk",
+  [SOLAR_NAUTICAL_DUSK] = "Naut.",
+  [SOLAR_ASTRO_DUSK]    = "Astro",
+};
+
+void fields_init(void) {
+  SolarFields saved = persist_exists(PERSIST_KEY_FIELDS) ? persist_read_int(PERSIST_KEY_FIELDS) : 0;
+  saved = solar_fields_clamp(saved);
+  s_fields = saved ? saved : SOLAR_FIELDS_CLASSIC;
+}
+
+SolarFields fields_get(void) {
+  return s_fields;
+}
+
+bool fields_apply(SolarFields fields) {
+  fields = solar_fields_clamp(fields);
+  if (!fields) fields = SOLAR_FIELDS_CLASSIC;
+  if (fields == s_fields) return false;
+  s_fields = fields;
+  persist_write_int(PERSIST_KEY_FIELDS, s_fields);
+  return true;
+}
+
+const char *fields_label(SolarField field) {
+  return field < SOLAR_FIELD_COUNT ? LABELS[field] : "";
+}
+
+const char *fields_name(SolarField field) {
+  switch (field) {
+    case SOLAR_ASTRO_DAWN:    return "Astro dawn";
+    case SOLAR_NAUTICAL_DAWN: return "Naut. dawn";
+    case SOLAR_NAUTICAL_DUSK: return "Naut. dusk";
+    case SOLAR_ASTRO_DUSK:    return "Astro dusk";
+    default:                  return fields_label(field);
+  }
+}
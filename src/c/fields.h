@@ -0,0 +1,21 @@
+#pragma once
+#include <pebble.h>
+#include "solar.h"
+
+// Which events the user wants shown, picked on the phone and kept on flash.
+// Everything downstream (cache, store, wire, rows on screen) follows this mask.
+
+// Load the saved mask; the four classic events if there is none
+void fields_init(void);
+
+SolarFields fields_get(void);
+
+// Take a new mask from the phone; false if it changes nothing
+bool fields_apply(SolarFields fields);
+
+// Short row label for a field
+const char *fields_label(SolarField field);
+
+// Label that says which event it is on its own, where the row labels lean on
+// their order (morning and evening twilight share one)
+const char *fields_name(SolarField field);
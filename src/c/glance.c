@@ -0,0 +1,83 @@
+#include <pebble.h>
+#include "glance.h"
+#include "cache.h"
+#include "fields.h"
+
+#if PBL_API_EXISTS(app_glance_reload)
+
+typedef struct {
+  time_t at;            // UTC
+  SolarField field;
+  int16_t minute;       // local minutes, for the text
+} GlanceEvent;
+
+static GlanceEvent s_events[GLANCE_SLICES];
+static uint8_t s_count;
+
+static bool prv_cached(int32_t day, SolarDay *out) {
+  for (int i = 0; i < cache_width(); i++) {
+    DayTimes *dt = cache_at(i);
+    if (dt && dt->day == day) {
+      *out = dt->times;
+      return true;
+    }
+  }
+  return false;
+}
+
+// Keep the GLANCE_SLICES soonest events after `now`, in time order. Field
+// order is not time order once an event wraps past midnight.
+static void prv_add(time_t now, time_t at, SolarField field, int16_t minute) {
+  if (at <= now) return;
+  if (s_count == GLANCE_SLICES && at >= s_events[s_count - 1].at) return;
+  int i = s_count < GLANCE_SLICES ? s_count++ : s_count - 1;
+  for (; i > 0 && s_events[i - 1].at > at; i--) s_events[i] = s_events[i - 1];
+  s_events[i] = (GlanceEvent) { .at = at, .field = field, .minute = minute };
+}
+
+static void prv_reload(AppGlanceReloadSession *session, size_t limit, void *context) {
+  static char s_text[GLANCE_SLICES][20];
+  for (uint8_t i = 0; i < s_count && i < limit; i++) {
+    const GlanceEvent *e = &s_events[i];
+    snprintf(s_text[i], sizeof(s_text[i]), "%s %02d:%02d",
+             fields_name(e->field), e->minute / 60, e->minute % 60);
+    AppGlanceSlice slice = {
+      .layout = {
+        .icon = APP_GLANCE_SLICE_DEFAULT_ICON,
+        .subtitle_template_string = s_text[i],
+      },
+      .expiration_time = e->at,
+    };
+    if (app_glance_add_slice(session, slice) != APP_GLANCE_RESULT_SUCCESS) break;
+  }
+}
+
+void glance_publish(const SolarLocation *loc, SolarFields fields, int32_t today) {
+  time_t now = time(NULL);
+  s_count = 0;
+  for (int d = 0; d < GLANCE_DAYS; d++) {
+    // Every event of a later day comes after all of these
+    if (s_count == GLANCE_SLICES) break;
+    int32_t day = today + d;
+    SolarDay times;
+    if (!prv_cached(day, &times)) solar_compute_day(loc, fields, day, &times);
+
+    uint8_t slot = 0;
+    for (int f = 0; f < SOLAR_FIELD_COUNT && slot < SOLAR_MAX_FIELDS; f++) {
+      if (!(fields & SOLAR_FIELD(f))) continue;
+      int16_t minute = times.minutes[slot++];
+      if (minute == SOLAR_NONE) continue;
+      time_t at = (time_t)day * SECONDS_PER_DAY + minute * SECONDS_PER_MINUTE - solar_offset_on(loc, day);
+      prv_add(now, at, f, minute);
+    }
+  }
+  // Even with nothing coming up, reloading clears slices for the last place
+  app_glance_reload(prv_reload, NULL);
+}
+
+#else
+
+void glance_publish(const SolarLocation *loc, SolarFields fields, int32_t today) {
+}
+
+#endif
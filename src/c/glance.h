@@ -0,0 +1,14 @@
+#pragma once
+#include <pebble.h>
+#include "solar.h"
+
+// Launcher glance: one slice per upcoming event, each expiring the moment its
+// event happens, so the launcher moves on to the next one by itself.
+// Published on the way out; a no-op on platforms without AppGlance.
+
+#define GLANCE_SLICES 8     // the launcher keeps no more than this many
+#define GLANCE_DAYS   8     // furthest ahead to look, for sparse field picks
+
+// Publish the next GLANCE_SLICES events from `today` on. Days come from the
+// cache where it has them and from the local engine otherwise.
+void glance_publish(const SolarLocation *loc, SolarFields fields, int32_t today);
@@ -0,0 +1,19 @@
+#include <pebble.h>
+#include "lowmem.h"
+
+static bool s_active = false;
+
+void lowmem_init(void) {
+  size_t free_bytes = heap_bytes_free();
+#ifdef HELIOS_LOW_MEMORY
+  s_active = true;
+#else
+  s_active = free_bytes < LOWMEM_HEAP_BYTES;
+#endif
+  APP_LOG(APP_LOG_LEVEL_INFO, "heap: %d bytes free at start, %s profile",
+          (int)free_bytes, s_active ? "low-memory" : "normal");
+}
+
+bool lowmem_active(void) {
+  return s_active;
+}
@@ -0,0 +1,15 @@
+#pragma once
+#include <pebble.h>
+
+// Low-memory profile. Picked once at start-up from what the heap has left
+// after code and static data, or forced by building with HELIOS_LOW_MEMORY
+// set in the environment. It trades cache depth (and with it the inbox
+// size), year chunk size and the day slide for free heap.
+
+// Below this much free heap at start-up the app runs lean
+#define LOWMEM_HEAP_BYTES 12000
+
+// Call first thing, before anything allocates
+void lowmem_init(void);
+
+bool lowmem_active(void);
@@ -2,15 +2,79 @@
 #include "msg.h"
 #include "ui.h"
 #include "types.h"
+#include "solar.h"
+#include "store.h"
+#include "wire.h"
+#include "cache.h"
+#include "retry.h"
+#include "stats.h"
+#include "scenario.h"
+#include "probe.h"
+#include "refresh.h"
+#include "year.h"
+#include "places.h"
+#include "fields.h"
+#include "lowmem.h"
+#include "glance.h"
 
-// Cache/state
+// State
 static int32_t s_day_offset = 0;      // currently displayed offset (0=today)
-static int32_t s_cache_center = 9999; // center offset of the cached bundle
-static DayTimes s_cache[3];           // 0: center-1, 1: center, 2: center+1
-static AppTimer *s_retry_timer = NULL;
+static int32_t s_today = 0;           // local day offsets are relative to; the cache is keyed by day
+static uint8_t s_wire_days = 3;       // days we ask the phone for at once
+static uint8_t s_phone_proto = 0;     // wire version the phone announced in HELLO
+static uint8_t s_chunk_days = 0;      // days per year-stream chunk
+static uint32_t s_inbox_size = 0;
+static bool s_phone_connected = false;
+
+// Year streams go out a month at a time so the chart fills in visibly
+#define YEAR_CHUNK_DAYS 31
+
+// AppMessage buffers are sized from the messages themselves rather than the
+// firmware maximum. A dictionary is a count byte, then a 7 byte header (key,
+// type, length) and the value for each tuple.
+#define DICT_TUPLE_SIZE(value) (7 + (value))
+
+// REQ is the largest thing we send: seven int32s (year requests carry six)
+#define MSG_OUTBOX_SIZE (1 + 7 * DICT_TUPLE_SIZE(sizeof(int32_t)))
+
+// PLACES, FIELDS and WORKER; HELLO and ERROR replies are smaller
+#define MSG_SETTINGS_SIZE (1 + DICT_TUPLE_SIZE(PLACES_MAX_SIZE) + 2 * DICT_TUPLE_SIZE(sizeof(int32_t)))
+
+// Request scheduling: at most one REQ in flight, tagged with a sequence
+// number the phone echoes back. Anything asked for meanwhile collapses into
+// one follow-up aimed at wherever the cursor is by the time it goes out.
+#define REQ_THROTTLE_MS      250    // least time between REQs while navigating
+#define REQ_REPLY_TIMEOUT_MS 9000   // pkjs may spend 7 s on geolocation
+#define REQ_REPLY_WARM_MS    2500   // once it has answered, it answers from its last fix
+
+static uint16_t s_req_seq = 0;        // sequence number of the last REQ sent
+static int32_t s_req_first = 0;       // first local day the last REQ asked for
+static uint8_t s_req_days = 0;        // and how many
+static bool s_req_in_flight = false;
+static bool s_req_pending = false;    // something newer is wanted
+static bool s_phone_warm = false;     // the phone has answered a REQ since connecting
+static AppTimer *s_throttle_timer = NULL;
+static AppTimer *s_reply_timer = NULL;
+
+// Location the days are computed for: the phone's fix ("Here") or a saved place
+static SolarLocation s_loc;
+static bool s_loc_valid = false;
+
+// Last fix reported by the phone, kept while a saved place is active. It
+// follows the watch's own zone, which the phone keeps in step with its own.
+static SolarLocation s_here;
+static bool s_here_valid = false;
+
+// The phone's next zone change (UTC_CHANGE, UTC_OFFSET_NEXT), for saved places
+static int32_t s_zone_change = SOLAR_ZONE_FIXED;
+static int32_t s_zone_next_offset = 0;
+static bool s_zone_valid = false;
+
+// Phone's name for what the cache holds (wire.h); 0 when it cannot know
+static uint16_t s_epoch = 0;
 
 // Utils
-static const char *prv_reason(AppMessageResult r) {
+const char *msg_reason_name(AppMessageResult r) {
   switch (r) {
     case APP_MSG_OK: return "OK";
     case APP_MSG_SEND_TIMEOUT: return "TIMEOUT";
@@ -30,198 +94,714 @@ static const char *prv_reason(AppMessageResult r) {
   }
 }
 
-static void prv_clear_cache(void) {
-  for (int i = 0; i < 3; i++) {
-    s_cache[i].valid = false;
-    s_cache[i].offset = 0;
-    s_cache[i].date[0] = 0;
-    s_cache[i].dawn[0] = 0;
-    s_cache[i].sunrise[0] = 0;
-    s_cache[i].sunset[0] = 0;
-    s_cache[i].dusk[0] = 0;
+static int32_t prv_today(void) {
+  time_t now = time(NULL);
+  if (s_loc_valid) return solar_local_day(&s_loc, now);
+  return (int32_t)((now + localtime(&now)->tm_gmtoff) / SECONDS_PER_DAY);
+}
+
+// "HH:MM" -> minutes since midnight, SOLAR_NONE for anything else
+static int16_t prv_parse_minutes(const char *s) {
+  if (s[0] < '0' || s[0] > '9' || s[1] < '0' || s[1] > '9' || s[2] != ':' ||
+      s[3] < '0' || s[3] > '9' || s[4] < '0' || s[4] > '9') {
+    return SOLAR_NONE;
   }
-  s_cache_center = 9999;
+  return (s[0] - '0') * 600 + (s[1] - '0') * 60 + (s[3] - '0') * 10 + (s[4] - '0');
 }
 
-static DayTimes *prv_cache_get_for_offset(int32_t offset) {
-  if (s_cache_center == 9999) return NULL;
-  if (offset == s_cache_center - 1) return &s_cache[0];
-  if (offset == s_cache_center)     return &s_cache[1];
-  if (offset == s_cache_center + 1) return &s_cache[2];
-  return NULL;
+// Re-anchor offsets on a new "today". Cached days keep their place; the
+// window just slides so the displayed offset lands on the right date.
+static bool prv_set_today(int32_t today) {
+  if (today == s_today) return false;
+  s_today = today;
+  cache_jump_to(s_today + s_day_offset);
+  return true;
 }
 
-static void prv_retry_cb(void *data);
+// Compute a day with the local engine straight into the cache
+static DayTimes *prv_fill_local(int32_t day) {
+  if (!s_loc_valid || scenario_phone_only()) return NULL;
 
-void msg_request_times(void) {
+  SolarDay sd;
+  solar_compute_day(&s_loc, fields_get(), day, &sd);
+  return cache_put(day, &sd);
+}
+
+// Show the current offset from cache or the local engine; false if neither has it
+static bool prv_show_current(void) {
+  int32_t day = s_today + s_day_offset;
+  DayTimes *dt = cache_get(day);
+  if (!dt) dt = prv_fill_local(day);
+  if (!dt) return false;
+  ui_show_daytimes(dt);
+  return true;
+}
+
+static bool prv_have_current(void) {
+  return (s_loc_valid && !scenario_phone_only()) || cache_has(s_today + s_day_offset);
+}
+
+// Background chatter only matters while there is nothing else on screen
+static void prv_status_if_empty(const char *text) {
+  if (!prv_have_current()) ui_show_status(text);
+}
+
+static void prv_status_detail_if_empty(const char *what, const char *detail) {
+  if (!prv_have_current()) ui_show_status_detail(what, detail);
+}
+
+// Switch the computed location; false if it is close enough to keep the cache
+static bool prv_use_location(const SolarLocation *loc) {
+  // Times cached for somewhere else are no longer worth showing
+  bool moved = !s_loc_valid || !store_same_location(&s_loc, loc);
+  if (moved) {
+    cache_clear();
+    s_epoch = 0;
+  }
+  s_loc = *loc;
+  s_loc_valid = true;
+  prv_set_today(prv_today());
+  return moved;
+}
+
+// Saved places are shown in the phone's zone; the phone has no zone database
+static bool prv_place_location(uint8_t index, SolarLocation *out) {
+  const Place *p = places_get(index);
+  if (!p) {
+    if (s_here_valid) *out = s_here;
+    return s_here_valid;
+  }
+  time_t now = time(NULL);
+  out->lat_e6 = p->lat_e6;
+  out->lon_e6 = p->lon_e6;
+  if (s_here_valid && s_zone_valid) {
+    // Saved places borrow the phone's zone, switching at its next change
+    out->utc_offset = s_here.utc_offset;
+    out->zone_change = s_zone_change;
+    out->next_offset = s_zone_next_offset;
+  } else {
+    out->utc_offset = localtime(&now)->tm_gmtoff;
+    out->zone_change = SOLAR_ZONE_WATCH;
+    out->next_offset = 0;
+  }
+  return true;
+}
+
+// Persistence: cache window <-> flash, keyed by absolute local day
+static void prv_restore_cache(void) {
+  StoreSnapshot *snap = malloc(sizeof(StoreSnapshot));
+  if (!snap) return;
+
+  if (store_load(snap)) {
+    s_loc = snap->loc;
+    s_loc_valid = true;
+    prv_set_today(prv_today());   // the stored zone may differ from the watch's
+
+    // Days saved with other fields are recomputed rather than shown half empty
+    if (snap->fields == fields_get()) {
+      s_epoch = snap->sync_epoch;
+      for (int i = 0; i < snap->count; i++) {
+        cache_put(snap->first_day + i, &snap->days[i]);
+      }
+    }
+  }
+  free(snap);
+
+  // The store follows whichever place was active; recompute if that changed
+  SolarLocation loc;
+  if (places_active() && prv_place_location(places_active(), &loc)) {
+    prv_use_location(&loc);
+  } else if (!places_active() && s_loc_valid) {
+    s_here = s_loc;
+    s_here_valid = true;
+  }
+}
+
+static void prv_save_cache(void) {
+  if (!s_loc_valid) return;
+  StoreSnapshot *snap = malloc(sizeof(StoreSnapshot));
+  if (!snap) return;
+
+  snap->loc = s_loc;
+  snap->sync_epoch = s_epoch;
+  snap->fields = fields_get();
+  snap->first_day = 0;
+  snap->count = 0;
+  for (int i = 0; i < cache_width(); i++) {
+    DayTimes *dt = cache_at(i);
+    if (!dt) {
+      if (snap->count) break;   // keep the run contiguous
+      continue;
+    }
+    if (!snap->count) snap->first_day = dt->day;
+    snap->days[snap->count++] = dt->times;
+  }
+  store_save(snap);
+  free(snap);
+}
+
+// The worker is opt-in: the watch runs one background app at a time, and
+// launching ours would ask to replace whatever the user keeps there
+static bool prv_worker_wanted(void) {
+  return persist_exists(PERSIST_KEY_WORKER_ON) && persist_read_bool(PERSIST_KEY_WORKER_ON);
+}
+
+// Settings arrive every time the phone side starts, so this also stops a
+// worker left running from before the user turned it off
+static void prv_set_worker_wanted(bool wanted) {
+  if (wanted != prv_worker_wanted()) persist_write_bool(PERSIST_KEY_WORKER_ON, wanted);
+  if (wanted) msg_start_worker();
+  else if (app_worker_is_running()) app_worker_kill();
+}
+
+void msg_start_worker(void) {
+  if (prv_worker_wanted() && !app_worker_is_running()) app_worker_launch();
+}
+
+// Hand the persisted days over to the background worker
+static void prv_notify_worker(uint8_t type) {
+  if (!app_worker_is_running()) return;
+  AppWorkerMessage msg = { 0 };
+  app_worker_send_message(type, &msg);
+}
+
+static void prv_log_worker_report(void) {
+  WorkerReport report;
+  if (!refresh_read_report(&report)) return;
+  APP_LOG(APP_LOG_LEVEL_INFO, "worker: trigger %d at %d, %d days from %d (%d computed)",
+          (int)report.trigger, (int)report.ran_at, (int)report.count,
+          (int)report.first_day, (int)report.computed);
+}
+
+static void prv_pump(void);
+static void prv_apply_active_place(void);
+static void prv_prefetch(void);
+static void prv_fields_changed(void);
+
+static void prv_reply_timeout_cb(void *data) {
+  s_reply_timer = NULL;
+  s_req_in_flight = false;
+  s_req_pending = true;   // assume it was lost and ask again
+  retry_schedule(APP_MSG_SEND_TIMEOUT);
+}
+
+static void prv_throttle_cb(void *data) {
+  s_throttle_timer = NULL;
+  prv_pump();
+}
+
+static void prv_request_done(void) {
+  stats_count(STAT_REPLY);
+  retry_reset();
+  s_req_in_flight = false;
+  s_phone_warm = true;
+  if (s_reply_timer) {
+    app_timer_cancel(s_reply_timer);
+    s_reply_timer = NULL;
+  }
+  prv_pump();
+}
+
+static void prv_send_request(void) {
   DictionaryIterator *iter;
-  AppMessageResult r = app_message_outbox_begin(&iter);
+  PROBE_START(t_begin);
+  AppMessageResult r = scenario_outbox_busy() ? APP_MSG_BUSY : app_message_outbox_begin(&iter);
+  PROBE_STOP(PROBE_OUTBOX_BEGIN, t_begin);
   if (r != APP_MSG_OK) {
-    static char s_buf[64];
-    snprintf(s_buf, sizeof(s_buf), "Outbox: %s", prv_reason(r));
-    ui_show_status(s_buf);
-    s_retry_timer = app_timer_register(2000, prv_retry_cb, NULL);
+    prv_status_detail_if_empty("Outbox", msg_reason_name(r));
+    retry_schedule(r);
     return;
   }
+  // The phone centres its bundle on OFFSET; aim it so the bundle covers the
+  // cache window, which already leans in the direction we are scrolling.
+  // Legacy phones only send center±1, so they get the displayed day.
+  PROBE_START(t_send);
   int32_t one = 1;
+  int32_t proto = WIRE_VERSION;
+  int32_t count = s_wire_days;
+  int32_t center = s_phone_proto >= 1 ? cache_window_first() - s_today + count / 2 : s_day_offset;
+  int32_t seq = ++s_req_seq;
+  int32_t epoch = s_epoch;
+  s_req_first = s_today + center - count / 2;
+  s_req_days = count;
+  int32_t fields = fields_get();
   dict_write_int(iter, MESSAGE_KEY_REQ, &one, sizeof(one), true);
-  dict_write_int(iter, MESSAGE_KEY_OFFSET, &s_day_offset, sizeof(s_day_offset), true);
+  dict_write_int(iter, MESSAGE_KEY_SEQ, &seq, sizeof(seq), true);
+  dict_write_int(iter, MESSAGE_KEY_EPOCH, &epoch, sizeof(epoch), true);
+  dict_write_int(iter, MESSAGE_KEY_FIELDS, &fields, sizeof(fields), true);
+  dict_write_int(iter, MESSAGE_KEY_OFFSET, &center, sizeof(center), true);
+  dict_write_int(iter, MESSAGE_KEY_PROTO, &proto, sizeof(proto), true);
+  dict_write_int(iter, MESSAGE_KEY_COUNT, &count, sizeof(count), true);
   dict_write_end(iter);
   app_message_outbox_send();
+  PROBE_STOP(PROBE_OUTBOX_SEND, t_send);
+  PROBE_MARK(PROBE_MARK_SENT);
+  PROBE_MARK(PROBE_MARK_REQ);
+  stats_count(STAT_REQ_SENT);
 
-  if (!prv_cache_get_for_offset(s_day_offset)) {
-    ui_show_status("Fetching…");
+  s_req_pending = false;
+  s_req_in_flight = true;
+  s_reply_timer = app_timer_register(s_phone_warm ? REQ_REPLY_WARM_MS : REQ_REPLY_TIMEOUT_MS,
+                                     prv_reply_timeout_cb, NULL);
+
+  prv_status_if_empty("Fetching…");
+}
+
+// Year stream requests and acks share the outbox with REQ. They never retry on
+// their own: a busy outbox just means prv_outbox_sent() pumps again.
+static void prv_send_year(void) {
+  DictionaryIterator *iter;
+  if (app_message_outbox_begin(&iter) != APP_MSG_OK) return;
+  year_write(iter, s_today);
+  dict_write_end(iter);
+  app_message_outbox_send();
+}
+
+static void prv_pump(void) {
+  if (s_req_pending && !s_req_in_flight && !s_throttle_timer) {
+    prv_send_request();
+    return;
+  }
+  if (year_wants_send()) prv_send_year();
+}
+
+// Navigation: ask right away, then at most once per REQ_THROTTLE_MS for
+// wherever the cursor has got to. A held button repeats faster than that, so
+// waiting for it to go quiet would ask nothing until it is let go.
+static void prv_request_throttled(void) {
+  s_req_pending = true;
+  if (s_throttle_timer) return;   // its callback asks for the latest
+  prv_pump();
+  s_throttle_timer = app_timer_register(REQ_THROTTLE_MS, prv_throttle_cb, NULL);
+}
+
+void msg_request_times(void) {
+  s_req_pending = true;
+  prv_pump();
+}
+
+
+// Binary bundle: a run of days decoded straight into the cache
+static void prv_apply_bundle(const uint8_t *data, uint16_t length) {
+  WireHeader hdr;
+  if (!wire_read_header(data, length, &hdr)) return;
+
+  // Bundles keep their version 1 layout, so this only ever raises it
+  if (hdr.version > s_phone_proto) s_phone_proto = hdr.version;
+  for (uint8_t i = 0; i < hdr.count; i++) {
+    int32_t day = hdr.base_day + hdr.first_offset + i;
+    SolarDay sd;
+    // An older phone only knows the classic four; work out the rest here
+    if (wire_read_day(data, &hdr, i, fields_get(), &sd)) cache_put(day, &sd);
+    else prv_fill_local(day);
+  }
+}
+
+// Patch: bring the cache from one epoch to the next in place. Days the phone
+// does not mention are already right once the shift is applied.
+// `latest` says the patch answers the last REQ, so it was cut for that range
+static void prv_apply_patch(const uint8_t *data, const WirePatch *patch, bool latest) {
+  if (patch->shift) cache_shift_minutes(patch->shift);
+  if (patch->from_epoch != patch->to_epoch) {
+    // The phone only compared the days it was asked for. Anything else in
+    // the cache is from the old epoch; prefetching fills it in again.
+    if (latest) cache_keep_range(s_req_first, s_req_days);
+    else cache_keep_range(0, 0);
+  }
+  for (uint8_t i = 0; i < patch->count; i++) {
+    int32_t day;
+    SolarDay sd;
+    if (wire_read_patch_day(data, patch, i, fields_get(), &day, &sd)) cache_put(day, &sd);
+  }
+  s_epoch = patch->to_epoch;
+  stats_count(STAT_PATCH);
+}
+
+static void prv_set_legacy(SolarDay *sd, SolarField field, const Tuple *t) {
+  int8_t slot = solar_field_slot(fields_get(), field);
+  if (slot >= 0 && slot < SOLAR_MAX_FIELDS) {
+    sd->minutes[slot] = t ? prv_parse_minutes(t->value->cstring) : SOLAR_NONE;
   }
 }
 
-static void prv_retry_cb(void *data) {
-  msg_request_times();
+static DayTimes *prv_fill_legacy(int32_t offset, const Tuple *dawn_t, const Tuple *sunrise_t,
+                                 const Tuple *sunset_t, const Tuple *dusk_t) {
+  if (!(dawn_t || sunrise_t || sunset_t || dusk_t)) return NULL;
+  // Legacy phones only send the classic four; anything else needs the local engine
+  if (fields_get() & ~SOLAR_FIELDS_CLASSIC) return prv_fill_local(s_today + offset);
+  SolarDay sd;
+  for (int f = 0; f < SOLAR_MAX_FIELDS; f++) sd.minutes[f] = SOLAR_NONE;
+  prv_set_legacy(&sd, SOLAR_DAWN, dawn_t);
+  prv_set_legacy(&sd, SOLAR_SUNRISE, sunrise_t);
+  prv_set_legacy(&sd, SOLAR_SUNSET, sunset_t);
+  prv_set_legacy(&sd, SOLAR_DUSK, dusk_t);
+  return cache_put(s_today + offset, &sd);
+}
+
+// String keys from a phone that predates the binary bundle
+static void prv_apply_legacy(DictionaryIterator *iter) {
+  Tuple *center_t = dict_find(iter, MESSAGE_KEY_CENTER);
+  if (!center_t) {
+    // Single-day payload
+    Tuple *dawn_t    = dict_find(iter, MESSAGE_KEY_DAWN);
+    Tuple *sunrise_t = dict_find(iter, MESSAGE_KEY_SUNRISE);
+    Tuple *sunset_t  = dict_find(iter, MESSAGE_KEY_SUNSET);
+    Tuple *dusk_t    = dict_find(iter, MESSAGE_KEY_DUSK);
+    prv_fill_legacy(s_day_offset, dawn_t, sunrise_t, sunset_t, dusk_t);
+    return;
+  }
+
+  int32_t center = center_t->value->int32;
+  prv_fill_legacy(center - 1,
+                  dict_find(iter, MESSAGE_KEY_DAWN_M1), dict_find(iter, MESSAGE_KEY_SUNRISE_M1),
+                  dict_find(iter, MESSAGE_KEY_SUNSET_M1), dict_find(iter, MESSAGE_KEY_DUSK_M1));
+  prv_fill_legacy(center,
+                  dict_find(iter, MESSAGE_KEY_DAWN_0), dict_find(iter, MESSAGE_KEY_SUNRISE_0),
+                  dict_find(iter, MESSAGE_KEY_SUNSET_0), dict_find(iter, MESSAGE_KEY_DUSK_0));
+  prv_fill_legacy(center + 1,
+                  dict_find(iter, MESSAGE_KEY_DAWN_P1), dict_find(iter, MESSAGE_KEY_SUNRISE_P1),
+                  dict_find(iter, MESSAGE_KEY_SUNSET_P1), dict_find(iter, MESSAGE_KEY_DUSK_P1));
 }
 
 // Inbox
+static void prv_inbox_parse(DictionaryIterator *iter);
+
 static void prv_inbox_received(DictionaryIterator *iter, void *context) {
+  PROBE_START(t_parse);
+  prv_inbox_parse(iter);
+  PROBE_STOP(PROBE_INBOX_PARSE, t_parse);
+}
+
+static void prv_inbox_parse(DictionaryIterator *iter) {
+  if (scenario_drop_reply()) {
+    stats_count(STAT_DROPPED);
+    return;
+  }
+
+  Tuple *chunk_t = dict_find(iter, MESSAGE_KEY_CHUNK);
+  if (chunk_t) {
+    Tuple *year_t = dict_find(iter, MESSAGE_KEY_YEAR);
+    if (year_t && chunk_t->type == TUPLE_BYTE_ARRAY) {
+      year_on_chunk(chunk_t->value->data, chunk_t->length, (uint16_t)year_t->value->int32);
+    }
+    return;
+  }
+
+  // Settings from the phone's config page
+  Tuple *places_t = dict_find(iter, MESSAGE_KEY_PLACES);
+  Tuple *fields_t = dict_find(iter, MESSAGE_KEY_FIELDS);
+  Tuple *worker_t = dict_find(iter, MESSAGE_KEY_WORKER);
+  if (places_t || fields_t || worker_t) {
+    if (worker_t) prv_set_worker_wanted(worker_t->value->int32 != 0);
+    if (fields_t && fields_apply((SolarFields)fields_t->value->int32)) prv_fields_changed();
+    uint8_t was = places_active();
+    if (places_t && places_t->type == TUPLE_BYTE_ARRAY &&
+        places_apply(places_t->value->data, places_t->length) && places_active() != was) {
+      prv_apply_active_place();
+    }
+    return;
+  }
+
   Tuple *hello_t = dict_find(iter, MESSAGE_KEY_HELLO);
   Tuple *error_t = dict_find(iter, MESSAGE_KEY_ERROR);
 
   if (hello_t) {
-    ui_show_status("Connected. Fetching…");
-    prv_clear_cache();
+    Tuple *proto_t = dict_find(iter, MESSAGE_KEY_PROTO);
+    s_phone_proto = proto_t ? (uint8_t)proto_t->value->int32 : 0;
+
+    // Keep whatever we have on screen and revalidate behind it
+    prv_status_if_empty("Connected. Fetching…");
     msg_request_times();
     return;
   }
 
+  // Replies to an older REQ are still merged (the cache ignores days outside
+  // its window) but only the latest one completes the request in flight
+  Tuple *seq_t = dict_find(iter, MESSAGE_KEY_SEQ);
+  bool latest = !seq_t || (uint16_t)seq_t->value->int32 == s_req_seq;
+  bool completes = latest && s_req_in_flight;
+  if (completes) prv_request_done();
+
   if (error_t) {
-    static char s_buf[64];
-    snprintf(s_buf, sizeof(s_buf), "Error: %s", error_t->value->cstring);
-    ui_show_status(s_buf);
+    ui_show_status_detail("Error", error_t->value->cstring);
     return;
   }
 
-  Tuple *center_t = dict_find(iter, MESSAGE_KEY_CENTER);
-  if (!center_t) {
-    // Legacy single-day payload
-    Tuple *date_t    = dict_find(iter, MESSAGE_KEY_DATE);
-    Tuple *dawn_t    = dict_find(iter, MESSAGE_KEY_DAWN);
-    Tuple *sunrise_t = dict_find(iter, MESSAGE_KEY_SUNRISE);
-    Tuple *sunset_t  = dict_find(iter, MESSAGE_KEY_SUNSET);
-    Tuple *dusk_t    = dict_find(iter, MESSAGE_KEY_DUSK);
-    if (date_t || dawn_t || sunrise_t || sunset_t || dusk_t) {
-      DayTimes tmp = { .valid = true, .offset = s_day_offset };
-      snprintf(tmp.date, sizeof(tmp.date), "%s", date_t ? date_t->value->cstring : "");
-      snprintf(tmp.dawn, sizeof(tmp.dawn), "%s", dawn_t ? dawn_t->value->cstring : "");
-      snprintf(tmp.sunrise, sizeof(tmp.sunrise), "%s", sunrise_t ? sunrise_t->value->cstring : "");
-      snprintf(tmp.sunset, sizeof(tmp.sunset), "%s", sunset_t ? sunset_t->value->cstring : "");
-      snprintf(tmp.dusk, sizeof(tmp.dusk), "%s", dusk_t ? dusk_t->value->cstring : "");
-      ui_show_daytimes(&tmp);
+  // Replies are always for the phone's own fix; a saved place only borrows its zone
+  bool here = places_active() == 0;
+
+  // A patch only makes sense against the epoch it was cut for
+  Tuple *patch_t = dict_find(iter, MESSAGE_KEY_PATCH);
+  WirePatch patch;
+  bool patch_ok = here && patch_t && patch_t->type == TUPLE_BYTE_ARRAY && s_epoch &&
+                  wire_read_patch(patch_t->value->data, patch_t->length, &patch) &&
+                  patch.from_epoch == s_epoch && patch.fields == fields_get();
+
+  bool moved = false;
+  Tuple *lat_t = dict_find(iter, MESSAGE_KEY_LAT);
+  Tuple *lon_t = dict_find(iter, MESSAGE_KEY_LON);
+  Tuple *utc_t = dict_find(iter, MESSAGE_KEY_UTC_OFFSET);
+  if (lat_t && lon_t && utc_t) {
+    s_here = (SolarLocation) {
+      .lat_e6 = lat_t->value->int32,
+      .lon_e6 = lon_t->value->int32,
+      .utc_offset = utc_t->value->int32,
+      .zone_change = SOLAR_ZONE_WATCH,
+    };
+    s_here_valid = true;
+    Tuple *change_t = dict_find(iter, MESSAGE_KEY_UTC_CHANGE);
+    Tuple *next_t = dict_find(iter, MESSAGE_KEY_UTC_OFFSET_NEXT);
+    s_zone_valid = change_t != NULL;
+    s_zone_change = change_t ? change_t->value->int32 : SOLAR_ZONE_FIXED;
+    s_zone_next_offset = next_t ? next_t->value->int32 : utc_t->value->int32;
+    if (patch_ok) {
+      // The patch carries the difference, so the cache stays
+      moved = !store_same_location(&s_loc, &s_here);
+      s_loc = s_here;
+      s_loc_valid = true;
+      prv_set_today(prv_today());
+    } else if (here) {
+      moved = prv_use_location(&s_here);
     }
-    return;
   }
 
-  int32_t center = center_t->value->int32;
-  s_cache_center = center;
-
-  // Center-1
-  Tuple *date_m1    = dict_find(iter, MESSAGE_KEY_DATE_M1);
-  Tuple *dawn_m1    = dict_find(iter, MESSAGE_KEY_DAWN_M1);
-  Tuple *sunrise_m1 = dict_find(iter, MESSAGE_KEY_SUNRISE_M1);
-  Tuple *sunset_m1  = dict_find(iter, MESSAGE_KEY_SUNSET_M1);
-  Tuple *dusk_m1    = dict_find(iter, MESSAGE_KEY_DUSK_M1);
-
-  // Center
-  Tuple *date_0    = dict_find(iter, MESSAGE_KEY_DATE_0);
-  Tuple *dawn_0    = dict_find(iter, MESSAGE_KEY_DAWN_0);
-  Tuple *sunrise_0 = dict_find(iter, MESSAGE_KEY_SUNRISE_0);
-  Tuple *sunset_0  = dict_find(iter, MESSAGE_KEY_SUNSET_0);
-  Tuple *dusk_0    = dict_find(iter, MESSAGE_KEY_DUSK_0);
-
-  // Center+1
-  Tuple *date_p1    = dict_find(iter, MESSAGE_KEY_DATE_P1);
-  Tuple *dawn_p1    = dict_find(iter, MESSAGE_KEY_DAWN_P1);
-  Tuple *sunrise_p1 = dict_find(iter, MESSAGE_KEY_SUNRISE_P1);
-  Tuple *sunset_p1  = dict_find(iter, MESSAGE_KEY_SUNSET_P1);
-  Tuple *dusk_p1    = dict_find(iter, MESSAGE_KEY_DUSK_P1);
-
-  #define FILL_SLOT(slot, off, t_date, t_dawn, t_sunrise, t_sunset, t_dusk) \
-    do { \
-      DayTimes *dt = &s_cache[slot]; \
-      dt->valid = (t_dawn || t_sunrise || t_sunset || t_dusk || t_date); \
-      dt->offset = (off); \
-      snprintf(dt->date, sizeof(dt->date), "%s", (t_date && t_date->value) ? t_date->value->cstring : ""); \
-      snprintf(dt->dawn, sizeof(dt->dawn), "%s", (t_dawn && t_dawn->value) ? t_dawn->value->cstring : ""); \
-      snprintf(dt->sunrise, sizeof(dt->sunrise), "%s", (t_sunrise && t_sunrise->value) ? t_sunrise->value->cstring : ""); \
-      snprintf(dt->sunset, sizeof(dt->sunset), "%s", (t_sunset && t_sunset->value) ? t_sunset->value->cstring : ""); \
-      snprintf(dt->dusk, sizeof(dt->dusk), "%s", (t_dusk && t_dusk->value) ? t_dusk->value->cstring : ""); \
-    } while (0)
-
-  FILL_SLOT(0, center - 1, date_m1, dawn_m1, sunrise_m1, sunset_m1, dusk_m1);
-  FILL_SLOT(1, center,     date_0,  dawn_0,  sunrise_0,  sunset_0,  dusk_0);
-  FILL_SLOT(2, center + 1, date_p1, dawn_p1, sunrise_p1, sunset_p1, dusk_p1);
-  #undef FILL_SLOT
-
-  DayTimes *dt = prv_cache_get_for_offset(s_day_offset);
-  if (dt && dt->valid) {
-    ui_show_daytimes(dt);
+  if (here) {
+    Tuple *bundle_t = dict_find(iter, MESSAGE_KEY_BUNDLE);
+    if (patch_ok) {
+      prv_apply_patch(patch_t->value->data, &patch, latest);
+    } else if (patch_t) {
+      // Cut for a cache we no longer hold: start over from a full bundle
+      s_epoch = 0;
+      msg_request_times();
+    } else if (bundle_t && bundle_t->type == TUPLE_BYTE_ARRAY) {
+      prv_apply_bundle(bundle_t->value->data, bundle_t->length);
+      Tuple *epoch_t = dict_find(iter, MESSAGE_KEY_EPOCH);
+      s_epoch = epoch_t ? (uint16_t)epoch_t->value->int32 : 0;
+    } else {
+      prv_apply_legacy(iter);
+      s_epoch = 0;
+    }
+  }
+
+  prv_show_current();
+  if (completes) PROBE_SINCE(PROBE_MARK_REQ, PROBE_REQ_TO_PAINT);
+  // Refill whatever the patch left out of the window
+  if (patch_ok) prv_prefetch();
+
+  if (moved) {
+    // Let the worker rebuild the week for the new place from what we just got
+    prv_save_cache();
+    prv_notify_worker(WORKER_MSG_REFRESH);
   }
 }
 
 static void prv_inbox_dropped(AppMessageResult reason, void *context) {
-  static char s_buf[40];
-  snprintf(s_buf, sizeof(s_buf), "Inbox dropped: %s", prv_reason(reason));
-  ui_show_status(s_buf);
+  prv_status_detail_if_empty("Inbox dropped", msg_reason_name(reason));
 }
 
 static void prv_outbox_failed(DictionaryIterator *iter, AppMessageResult reason, void *context) {
-  static char s_buf[48];
-  snprintf(s_buf, sizeof(s_buf), "Send failed: %s", prv_reason(reason));
-  ui_show_status(s_buf);
-  s_retry_timer = app_timer_register(1200, prv_retry_cb, NULL);
+  if (!dict_find(iter, MESSAGE_KEY_REQ)) {
+    year_on_send_failed();
+    return;
+  }
+
+  prv_status_detail_if_empty("Send failed", msg_reason_name(reason));
+  s_req_in_flight = false;
+  if (s_reply_timer) {
+    app_timer_cancel(s_reply_timer);
+    s_reply_timer = NULL;
+  }
+  retry_schedule(reason);
 }
 
 static void prv_outbox_sent(DictionaryIterator *iter, void *context) {
-  // No-op
+  if (dict_find(iter, MESSAGE_KEY_REQ)) PROBE_SINCE(PROBE_MARK_SENT, PROBE_OUTBOX_ACK);
+  prv_pump();   // something may have been waiting for the outbox
+}
+
+// Days per REQ: as many as fit in the inbox at the current record width
+static void prv_size_requests(void) {
+  uint8_t fit = wire_days_for_inbox(s_inbox_size, fields_get());
+  s_wire_days = fit < cache_width() ? fit : cache_width();
+}
+
+// Room for a reply covering the whole window at the widest record the user
+// can pick, and for a month of the year stream unless memory is short (the
+// chunks then shrink to whatever fits)
+static uint32_t prv_inbox_size(void) {
+  uint32_t size = wire_reply_size(cache_width(), solar_fields_clamp(SOLAR_FIELDS_ALL));
+  if (!lowmem_active()) {
+    uint32_t year = wire_reply_size(YEAR_CHUNK_DAYS, YEAR_FIELDS);
+    if (year > size) size = year;
+  }
+  if (MSG_SETTINGS_SIZE > size) size = MSG_SETTINGS_SIZE;
+  uint32_t max = app_message_inbox_size_maximum();
+  return size < max ? size : max;
 }
 
 // Public API
 void msg_init(void) {
-  prv_clear_cache();
+  s_today = prv_today();
+  cache_set_width(lowmem_active() ? CACHE_DAYS_LOW : CACHE_DAYS);
+  cache_jump_to(s_today + s_day_offset);
+  cache_clear();
+  prv_log_worker_report();
+  places_init();
+  fields_init();
+  ui_set_fields(fields_get());
+  prv_restore_cache();
+  prv_show_current();   // paint today from flash before the phone answers
+
+  retry_init(msg_request_times);
 
   app_message_register_inbox_received(prv_inbox_received);
   app_message_register_inbox_dropped(prv_inbox_dropped);
   app_message_register_outbox_failed(prv_outbox_failed);
   app_message_register_outbox_sent(prv_outbox_sent);
 
-  app_message_open(app_message_inbox_size_maximum(),
-                   app_message_outbox_size_maximum());
+  s_inbox_size = prv_inbox_size();
+  prv_size_requests();
+  uint8_t fit = wire_days_for_inbox(s_inbox_size, YEAR_FIELDS);
+  s_chunk_days = fit < YEAR_CHUNK_DAYS ? fit : YEAR_CHUNK_DAYS;
+
+  uint32_t outbox_max = app_message_outbox_size_maximum();
+  app_message_open(s_inbox_size, MSG_OUTBOX_SIZE < outbox_max ? MSG_OUTBOX_SIZE : outbox_max);
 }
 
 void msg_deinit(void) {
-  if (s_retry_timer) {
-    app_timer_cancel(s_retry_timer);
-    s_retry_timer = NULL;
+  stats_log();
+
+  prv_save_cache();
+  prv_notify_worker(WORKER_MSG_EXTEND);
+  if (s_loc_valid) glance_publish(&s_loc, fields_get(), s_today);
+  retry_deinit();
+  if (s_throttle_timer) {
+    app_timer_cancel(s_throttle_timer);
+    s_throttle_timer = NULL;
+  }
+  if (s_reply_timer) {
+    app_timer_cancel(s_reply_timer);
+    s_reply_timer = NULL;
   }
   app_message_deregister_callbacks();
 }
 
 void msg_on_phone_conn_changed(bool connected) {
   if (connected) {
-    ui_show_status("Connecting…");
-    s_retry_timer = app_timer_register(400, prv_retry_cb, NULL);
+    prv_status_if_empty("Connecting…");
   } else {
-    ui_show_status("Waiting for phone…");
+    prv_status_if_empty("Waiting for phone…");
+    s_phone_warm = false;
+  }
+  retry_set_connected(connected);
+
+  // An open year view keeps filling: from the phone, or locally while it is away
+  s_phone_connected = connected;
+  if (!year_table()) return;
+  if (connected) year_start_stream(s_chunk_days);
+  else if (s_loc_valid) year_fill_local(&s_loc);
+}
+
+// Fill the rest of the window, ahead of the cursor first
+static void prv_prefetch(void) {
+  int32_t day;
+  if (!cache_next_missing(&day)) return;
+
+  if (s_loc_valid && !scenario_phone_only()) {
+    // Cheap enough to do inline; only the days that just slid in are missing
+    do {
+      prv_fill_local(day);
+    } while (cache_next_missing(&day));
+  } else {
+    prv_request_throttled();
   }
 }
 
 void msg_navigate_to_offset(int32_t new_offset) {
+  stats_count(STAT_NAV);
+  stats_mark_press();
+  if (new_offset != s_day_offset) ui_set_transition(new_offset > s_day_offset ? 1 : -1);
   s_day_offset = new_offset;
+  cache_set_cursor(s_today + new_offset);
 
-  DayTimes *dt = prv_cache_get_for_offset(s_day_offset);
-  if (dt && dt->valid) {
-    ui_show_daytimes(dt);  // instant
-  } else {
+  if (!prv_show_current()) {
     ui_show_status("Fetching…");
   }
 
-  msg_request_times();
+  // Once we know where we are, the phone is only needed to refresh the location.
+  // The local engine is exact to the minute for any date, so there is no
+  // approximate stage while scrolling: each step costs one solve at most.
+  prv_prefetch();
+}
+
+void msg_on_day_changed(void) {
+  if (!prv_set_today(prv_today())) return;
+
+  // Whatever is already cached for the new date is reused as is; only the
+  // day that slid into the window needs computing or asking for
+  if (!prv_show_current()) ui_show_status("Fetching…");
+  prv_prefetch();
+}
+
+bool msg_open_year(int32_t first_day, uint16_t count, YearUpdateHandler on_update) {
+  if (!year_open(first_day, count, on_update)) return false;
+  if (s_phone_connected) year_start_stream(s_chunk_days);
+  else if (s_loc_valid) year_fill_local(&s_loc);
+  return true;
+}
+
+void msg_close_year(void) {
+  year_close();
+}
+
+void msg_kick_outbox(void) {
+  prv_pump();
+}
+
+// Compute for whichever place is now active and repaint from memory
+static void prv_apply_active_place(void) {
+  SolarLocation loc;
+  bool moved = false;
+  if (prv_place_location(places_active(), &loc)) {
+    moved = prv_use_location(&loc);
+  } else {
+    // "Here" before the phone has reported a fix: nothing to compute from
+    s_loc_valid = false;
+    s_epoch = 0;
+    cache_clear();
+    msg_request_times();
+  }
+
+  ui_flash_title(places_name(places_active()));
+  if (!prv_show_current()) ui_show_status("Fetching…");
+  prv_prefetch();
+
+  if (moved) {
+    prv_save_cache();
+    prv_notify_worker(WORKER_MSG_REFRESH);
+  }
+}
+
+// Different rows: everything cached or stored has the wrong shape now
+static void prv_fields_changed(void) {
+  prv_size_requests();
+  cache_clear();
+  s_epoch = 0;
+  ui_set_fields(fields_get());
+  if (!prv_show_current()) ui_show_status("Fetching…");
+  prv_prefetch();
+  if (!s_loc_valid || scenario_phone_only()) return;
+  prv_save_cache();
+  prv_notify_worker(WORKER_MSG_REFRESH);
+}
+
+void msg_cycle_place(void) {
+  places_cycle();
+  prv_apply_active_place();
+}
+
+int32_t msg_get_today(void) {
+  return s_today;
 }
 
 int32_t msg_get_day_offset(void) {
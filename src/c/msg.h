@@ -1,5 +1,6 @@
 #pragma once
 #include <pebble.h>
+#include "year.h"
 
 // Initialize/destroy messaging and cache
 void msg_init(void);
@@ -12,5 +13,25 @@ void msg_request_times(void);
 // Connection change
 void msg_on_phone_conn_changed(bool connected);
 
+// Local midnight passed: offset 0 becomes the new date
+void msg_on_day_changed(void);
+
+// Year view: allocate the table and start filling it from the phone (or
+// locally when the phone is away); closing frees it and drops the stream
+bool msg_open_year(int32_t first_day, uint16_t count, YearUpdateHandler on_update);
+void msg_close_year(void);
+
+// Make the next saved place active (wrapping back to "Here") and show it
+void msg_cycle_place(void);
+
+// Launch the background worker (worker_src/) if the user opted in to it on
+// the phone's config page
+void msg_start_worker(void);
+
+// Send anything queued for the outbox (year stream acks) if it is free
+void msg_kick_outbox(void);
+
 // Accessors
+int32_t msg_get_today(void);
 int32_t msg_get_day_offset(void);
+const char *msg_reason_name(AppMessageResult r);
@@ -0,0 +1,80 @@
+#include <pebble.h>
+#include "places.h"
+#include "store.h"
+
+// Saved places only; "Here" is implicit
+typedef struct {
+  uint8_t count;
+  Place places[PLACES_MAX - 1];
+} PlaceList;
+
+_Static_assert(sizeof(PlaceList) <= PERSIST_DATA_MAX_LENGTH, "PlaceList exceeds persist limit");
+
+static PlaceList s_list;
+static uint8_t s_active = 0;
+
+static int32_t prv_read_i32(const uint8_t *p) {
+  return (int32_t)((uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24);
+}
+
+void places_init(void) {
+  if (persist_read_data(PERSIST_KEY_PLACES, &s_list, sizeof(s_list)) < 1 ||
+      s_list.count > PLACES_MAX - 1) {
+    s_list.count = 0;
+  }
+  s_active = persist_exists(PERSIST_KEY_PLACE_ACTIVE) ? persist_read_int(PERSIST_KEY_PLACE_ACTIVE) : 0;
+  if (s_active >= places_count()) s_active = 0;
+}
+
+bool places_apply(const uint8_t *data, uint16_t length) {
+  if (length < 2 || data[0] != PLACES_VERSION) return false;
+
+  PlaceList list = { 0 };
+  uint16_t pos = 2;
+  for (uint8_t i = 0; i < data[1] && list.count < PLACES_MAX - 1; i++) {
+    if (pos >= length) return false;
+    uint8_t name_len = data[pos++];
+    if (pos + name_len + 8 > length) return false;
+
+    Place *p = &list.places[list.count++];
+    uint8_t copy = name_len < PLACE_NAME_LEN - 1 ? name_len : PLACE_NAME_LEN - 1;
+    memcpy(p->name, &data[pos], copy);
+    p->name[copy] = 0;
+    pos += name_len;
+    p->lat_e6 = prv_read_i32(&data[pos]);
+    p->lon_e6 = prv_read_i32(&data[pos + 4]);
+    pos += 8;
+  }
+
+  s_list = list;
+  persist_write_data(PERSIST_KEY_PLACES, &s_list, sizeof(s_list));
+  if (s_active >= places_count()) {
+    s_active = 0;
+    persist_write_int(PERSIST_KEY_PLACE_ACTIVE, s_active);
+  }
+  return true;
+}
+
+uint8_t places_count(void) {
+  return s_list.count + 1;
+}
+
+uint8_t places_active(void) {
+  return s_active;
+}
+
+const Place *places_get(uint8_t index) {
+  if (index == 0 || index > s_list.count) return NULL;
+  return &s_list.places[index - 1];
+}
+
+const char *places_name(uint8_t index) {
+  const Place *p = places_get(index);
+  return p ? p->name : "Here";
+}
+
+uint8_t places_cycle(void) {
+  s_active = (s_active + 1) % places_count();
+  persist_write_int(PERSIST_KEY_PLACE_ACTIVE, s_active);
+  return s_active;
+}
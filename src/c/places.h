@@ -0,0 +1,36 @@
+#pragma once
+#include <pebble.h>
+
+// Saved locations configured on the phone. Index 0 is always "Here", the
+// phone's own fix; the rest arrive in one packed PLACES message:
+//
+//   0  u8  version        PLACES_VERSION
+//   1  u8  count
+//   2  count x { u8 name_len, name bytes, i32 lat_e6, i32 lon_e6 }
+
+#define PLACES_VERSION   1
+#define PLACES_MAX       6     // including "Here"
+#define PLACE_NAME_LEN   16    // with terminator
+
+// Largest PLACES payload: every saved place with a full-length name
+#define PLACES_MAX_SIZE  (2 + (PLACES_MAX - 1) * (1 + (PLACE_NAME_LEN - 1) + 2 * 4))
+
+typedef struct {
+  char name[PLACE_NAME_LEN];
+  int32_t lat_e6;
+  int32_t lon_e6;
+} Place;
+
+// Load the saved list and the active index from flash
+void places_init(void);
+
+// Replace the saved list from a PLACES payload; false if malformed
+bool places_apply(const uint8_t *data, uint16_t length);
+
+uint8_t places_count(void);
+uint8_t places_active(void);
+const Place *places_get(uint8_t index);   // NULL for "Here"
+const char *places_name(uint8_t index);
+
+// Make the next place active (wrapping back to "Here") and return it
+uint8_t places_cycle(void);
@@ -0,0 +1,172 @@
+#include <pebble.h>
+#include "probe.h"
+
+#ifdef HELIOS_PROBES
+#include "cache.h"
+#include "msg.h"
+#include "store.h"
+
+#define PROBE_VERSION  1
+
+// Log2 buckets: [0], [1], [2,3], [4,7] ... [1024, inf)
+#define PROBE_BUCKETS  12
+#define PROBE_REASONS  16   // one per AppMessageResult bit
+
+// Saved as-is; every field is naturally aligned so there is no padding to worry about
+typedef struct {
+  uint16_t version;
+  uint16_t timers[PROBE_TIMER_COUNT][PROBE_BUCKETS];
+  uint16_t retries[PROBE_REASONS];
+  uint16_t reserved;
+  uint32_t cache_hits;
+  uint32_t cache_misses;
+  uint32_t heap_min;
+} ProbeHistogram;
+
+_Static_assert(sizeof(ProbeHistogram) <= PERSIST_DATA_MAX_LENGTH, "ProbeHistogram exceeds persist limit");
+
+static ProbeHistogram s_hist;
+static uint32_t s_marks[PROBE_MARK_COUNT];   // 0 while unset
+
+static Window *s_overlay_window;
+static TextLayer *s_overlay_layer;
+static char s_overlay_buf[200];
+
+static const char *TIMER_NAMES[PROBE_TIMER_COUNT] = {
+  "begin", "send", "ack", "parse", "show", "draw", "press", "req"
+};
+
+uint32_t probe_now(void) {
+  time_t s;
+  uint16_t ms = time_ms(&s, NULL);
+  return (uint32_t)s * 1000 + ms;
+}
+
+static uint8_t prv_bucket(uint32_t ms) {
+  uint8_t b = 0;
+  while (ms && b < PROBE_BUCKETS - 1) {
+    ms >>= 1;
+    b++;
+  }
+  return b;
+}
+
+// Largest value a bucket holds; what percentiles are reported as
+static uint32_t prv_bucket_top(uint8_t b) {
+  return b ? (1u << b) - 1 : 0;
+}
+
+static void prv_bump(uint16_t *c) {
+  if (*c < UINT16_MAX) (*c)++;
+}
+
+void probe_record(ProbeTimer timer, uint32_t ms) {
+  prv_bump(&s_hist.timers[timer][prv_bucket(ms)]);
+}
+
+void probe_mark(ProbeMark mark) {
+  s_marks[mark] = probe_now() | 1;
+}
+
+void probe_since(ProbeMark mark, ProbeTimer timer) {
+  if (!s_marks[mark]) return;
+  probe_record(timer, probe_now() - s_marks[mark]);
+  s_marks[mark] = 0;
+}
+
+void probe_retry(AppMessageResult reason) {
+  uint8_t bit = 0;
+  while (bit < PROBE_REASONS - 1 && !((uint32_t)reason & (1u << bit))) bit++;
+  prv_bump(&s_hist.retries[bit]);
+}
+
+void probe_heap(void) {
+  uint32_t free_bytes = heap_bytes_free();
+  if (!s_hist.heap_min || free_bytes < s_hist.heap_min) s_hist.heap_min = free_bytes;
+}
+
+void probe_init(void) {
+  if (persist_read_data(PERSIST_KEY_PROBES, &s_hist, sizeof(s_hist)) != (int)sizeof(s_hist) ||
+      s_hist.version != PROBE_VERSION) {
+    memset(&s_hist, 0, sizeof(s_hist));
+    s_hist.version = PROBE_VERSION;
+  }
+}
+
+void probe_deinit(void) {
+  const CacheStats *stats = cache_get_stats();
+  s_hist.cache_hits += stats->hits;
+  s_hist.cache_misses += stats->misses;
+  persist_write_data(PERSIST_KEY_PROBES, &s_hist, sizeof(s_hist));
+}
+
+// Value below which pct percent of the samples fall, to bucket resolution
+static uint32_t prv_percentile(ProbeTimer timer, uint8_t pct) {
+  uint32_t total = 0;
+  for (int b = 0; b < PROBE_BUCKETS; b++) total += s_hist.timers[timer][b];
+  if (!total) return 0;
+
+  uint32_t want = (total * pct + 99) / 100, seen = 0;
+  for (int b = 0; b < PROBE_BUCKETS; b++) {
+    seen += s_hist.timers[timer][b];
+    if (seen >= want) return prv_bucket_top(b);
+  }
+  return prv_bucket_top(PROBE_BUCKETS - 1);
+}
+
+static void prv_format(void) {
+  const CacheStats *stats = cache_get_stats();
+  uint32_t hits = s_hist.cache_hits + stats->hits;
+  uint32_t lookups = hits + s_hist.cache_misses + stats->misses;
+
+  int n = snprintf(s_overlay_buf, sizeof(s_overlay_buf),
+                   "p50/p95 ms\npress %d/%d\nreq %d/%d\n",
+                   (int)prv_percentile(PROBE_PRESS_TO_PAINT, 50),
+                   (int)prv_percentile(PROBE_PRESS_TO_PAINT, 95),
+                   (int)prv_percentile(PROBE_REQ_TO_PAINT, 50),
+                   (int)prv_percentile(PROBE_REQ_TO_PAINT, 95));
+  for (int t = PROBE_OUTBOX_BEGIN; t <= PROBE_DRAW && n < (int)sizeof(s_overlay_buf); t++) {
+    n += snprintf(s_overlay_buf + n, sizeof(s_overlay_buf) - n, "%s %d ",
+                  TIMER_NAMES[t], (int)prv_percentile(t, 95));
+  }
+  if (n < (int)sizeof(s_overlay_buf)) {
+    n += snprintf(s_overlay_buf + n, sizeof(s_overlay_buf) - n, "\nhit %d%% heap %dB\n",
+                  lookups ? (int)(hits * 100 / lookups) : 0, (int)s_hist.heap_min);
+  }
+  for (int r = 0; r < PROBE_REASONS && n < (int)sizeof(s_overlay_buf); r++) {
+    if (!s_hist.retries[r]) continue;
+    n += snprintf(s_overlay_buf + n, sizeof(s_overlay_buf) - n, "%s %d ",
+                  msg_reason_name((AppMessageResult)(1u << r)), (int)s_hist.retries[r]);
+  }
+}
+
+static void prv_overlay_load(Window *window) {
+  Layer *root = window_get_root_layer(window);
+  s_overlay_layer = text_layer_create(layer_get_bounds(root));
+  text_layer_set_background_color(s_overlay_layer, GColorBlack);
+  text_layer_set_text_color(s_overlay_layer, GColorWhite);
+  text_layer_set_font(s_overlay_layer, fonts_get_system_font(FONT_KEY_GOTHIC_14));
+  text_layer_set_overflow_mode(s_overlay_layer, GTextOverflowModeWordWrap);
+  prv_format();
+  text_layer_set_text(s_overlay_layer, s_overlay_buf);
+  layer_add_child(root, text_layer_get_layer(s_overlay_layer));
+}
+
+static void prv_overlay_unload(Window *window) {
+  text_layer_destroy(s_overlay_layer);
+  s_overlay_layer = NULL;
+  window_destroy(s_overlay_window);
+  s_overlay_window = NULL;
+}
+
+void probe_show_overlay(void) {
+  if (s_overlay_window) return;
+  s_overlay_window = window_create();
+  window_set_window_handlers(s_overlay_window, (WindowHandlers) {
+    .load = prv_overlay_load,
+    .unload = prv_overlay_unload,
+  });
+  window_stack_push(s_overlay_window, true);
+}
+
+#endif
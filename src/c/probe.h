@@ -0,0 +1,59 @@
+#pragma once
+#include <pebble.h>
+
+// Hot-path timing probes. Build with HELIOS_PROBES set in the environment to
+// compile them in; otherwise every PROBE_* macro expands to nothing.
+
+typedef enum {
+  PROBE_OUTBOX_BEGIN,     // app_message_outbox_begin()
+  PROBE_OUTBOX_SEND,      // writing the dictionary and app_message_outbox_send()
+  PROBE_OUTBOX_ACK,       // send until the phone acked it
+  PROBE_INBOX_PARSE,      // prv_inbox_received()
+  PROBE_SHOW,             // ui_show_daytimes()
+  PROBE_DRAW,             // content layer update proc
+  PROBE_PRESS_TO_PAINT,   // navigation until the day is on screen
+  PROBE_REQ_TO_PAINT,     // REQ sent until its reply is on screen
+  PROBE_TIMER_COUNT
+} ProbeTimer;
+
+// Start points for spans that cross callbacks
+typedef enum {
+  PROBE_MARK_SENT,
+  PROBE_MARK_REQ,
+  PROBE_MARK_COUNT
+} ProbeMark;
+
+#ifdef HELIOS_PROBES
+
+uint32_t probe_now(void);
+void probe_record(ProbeTimer timer, uint32_t ms);
+void probe_mark(ProbeMark mark);
+void probe_since(ProbeMark mark, ProbeTimer timer);
+void probe_retry(AppMessageResult reason);
+void probe_heap(void);
+
+// Load/save the histogram across launches
+void probe_init(void);
+void probe_deinit(void);
+
+void probe_show_overlay(void);
+
+#define PROBE_START(var)         uint32_t var = probe_now()
+#define PROBE_STOP(timer, var)   probe_record((timer), probe_now() - (var))
+#define PROBE_RECORD(timer, ms)  probe_record((timer), (ms))
+#define PROBE_MARK(mark)         probe_mark(mark)
+#define PROBE_SINCE(mark, timer) probe_since((mark), (timer))
+#define PROBE_RETRY(reason)      probe_retry(reason)
+#define PROBE_HEAP()             probe_heap()
+
+#else
+
+#define PROBE_START(var)
+#define PROBE_STOP(timer, var)   ((void)0)
+#define PROBE_RECORD(timer, ms)  ((void)0)
+#define PROBE_MARK(mark)         ((void)0)
+#define PROBE_SINCE(mark, timer) ((void)0)
+#define PROBE_RETRY(reason)      ((void)0)
+#define PROBE_HEAP()             ((void)0)
+
+#endif
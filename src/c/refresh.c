@@ -0,0 +1,45 @@
+#include "sdk.h"
+#include "refresh.h"
+#include "solar.h"
+#include "store.h"
+
+bool refresh_store(RefreshTrigger trigger, bool recompute) {
+  StoreSnapshot *snap = malloc(sizeof(StoreSnapshot));
+  if (!snap) return false;
+  if (!store_load(snap)) {
+    free(snap);
+    return false;
+  }
+
+  // store_load() already dropped the days behind us, so a run that starts
+  // today only needs extending; anything else is rebuilt from today
+  int32_t today = solar_local_day(&snap->loc, time(NULL));
+  if (recompute || snap->first_day != today) {
+    snap->first_day = today;
+    snap->count = 0;
+  }
+
+  uint8_t computed = 0;
+  while (snap->count < REFRESH_DAYS) {
+    solar_compute_day(&snap->loc, snap->fields, snap->first_day + snap->count, &snap->days[snap->count]);
+    snap->count++;
+    computed++;
+  }
+  if (computed) store_save(snap);
+
+  WorkerReport report = {
+    .ran_at = (int32_t)time(NULL),
+    .first_day = snap->first_day,
+    .count = snap->count,
+    .computed = computed,
+    .trigger = trigger,
+  };
+  persist_write_data(PERSIST_KEY_WORKER, &report, sizeof(report));
+
+  free(snap);
+  return true;
+}
+
+bool refresh_read_report(WorkerReport *out) {
+  return persist_read_data(PERSIST_KEY_WORKER, out, sizeof(*out)) == (int)sizeof(*out);
+}
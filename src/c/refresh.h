@@ -0,0 +1,35 @@
+#pragma once
+#include "sdk.h"
+
+// Keeping the persisted days current without the phone. Shared by the app
+// and the background worker (worker_src/), which calls it around midnight
+// and whenever the app reports a new location.
+
+// Days from today the worker keeps on flash: enough to open on any day of the coming week
+#define REFRESH_DAYS 8
+
+typedef enum {
+  REFRESH_START = 1,      // worker launched
+  REFRESH_MIDNIGHT = 2,   // day rolled over
+  REFRESH_LOCATION = 3,   // app saw a new location
+  REFRESH_APP_EXIT = 4,   // app saved its window on the way out
+} RefreshTrigger;
+
+// App -> worker messages, sent after the app has written the store
+#define WORKER_MSG_REFRESH 1    // new location: recompute everything
+#define WORKER_MSG_EXTEND  2    // top the stored run back up to REFRESH_DAYS
+
+// What the worker last did, for the app to log
+typedef struct {
+  int32_t ran_at;         // UTC seconds
+  int32_t first_day;      // local day of the first stored day
+  uint8_t count;          // days now stored
+  uint8_t computed;       // of which computed on this run
+  uint8_t trigger;        // RefreshTrigger
+} WorkerReport;
+
+// Bring the stored run up to REFRESH_DAYS from today. Only days not already
+// stored are computed, unless `recompute` is set. False without a location.
+bool refresh_store(RefreshTrigger trigger, bool recompute);
+
+bool refresh_read_report(WorkerReport *out);
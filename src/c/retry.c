@@ -0,0 +1,99 @@
+#include <pebble.h>
+#include "retry.h"
+#include "stats.h"
+#include "probe.h"
+
+#define RETRY_RECONNECT_MS 400   // let the link settle before the first attempt
+
+typedef struct {
+  uint16_t base_ms;
+  uint16_t cap_ms;
+} RetryPolicy;
+
+// The outbox being busy clears quickly; a silent phone deserves patience
+static const RetryPolicy POLICY_BUSY    = { 150,  2000 };
+static const RetryPolicy POLICY_TIMEOUT = { 1000, 30000 };
+static const RetryPolicy POLICY_OTHER   = { 2000, 60000 };
+
+static RetryHandler s_handler = NULL;
+static AppTimer *s_timer = NULL;
+static uint8_t s_attempt = 0;
+static bool s_connected = false;  // until the connection service says otherwise
+static bool s_parked = false;        // a retry is owed once we reconnect
+
+static void prv_cancel(void) {
+  if (s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+}
+
+static void prv_timer_cb(void *data) {
+  s_timer = NULL;
+  if (s_handler) s_handler();
+}
+
+static void prv_arm(uint32_t delay_ms) {
+  prv_cancel();
+  s_timer = app_timer_register(delay_ms, prv_timer_cb, NULL);
+}
+
+static const RetryPolicy *prv_policy(AppMessageResult reason) {
+  switch (reason) {
+    case APP_MSG_BUSY: return &POLICY_BUSY;
+    case APP_MSG_SEND_TIMEOUT: return &POLICY_TIMEOUT;
+    default: return &POLICY_OTHER;
+  }
+}
+
+// base * 2^attempt, capped, then "equal jitter": somewhere in [d/2, d]
+static uint32_t prv_delay_ms(const RetryPolicy *p, uint8_t attempt) {
+  uint32_t d = p->base_ms;
+  for (uint8_t i = 0; i < attempt && d < p->cap_ms; i++) d <<= 1;
+  if (d > p->cap_ms) d = p->cap_ms;
+  return d / 2 + (uint32_t)rand() % (d / 2 + 1);
+}
+
+void retry_init(RetryHandler handler) {
+  s_handler = handler;
+  srand(time(NULL));
+}
+
+void retry_deinit(void) {
+  prv_cancel();
+  s_handler = NULL;
+}
+
+void retry_schedule(AppMessageResult reason) {
+  stats_count(STAT_RETRY);
+  PROBE_RETRY(reason);
+  if (!s_connected || reason == APP_MSG_NOT_CONNECTED) {
+    // Nothing will get through; wait for the connection service instead
+    prv_cancel();
+    s_parked = true;
+    return;
+  }
+  prv_arm(prv_delay_ms(prv_policy(reason), s_attempt));
+  if (s_attempt < 8) s_attempt++;
+}
+
+void retry_reset(void) {
+  prv_cancel();
+  s_attempt = 0;
+  s_parked = false;
+}
+
+void retry_set_connected(bool connected) {
+  bool was_connected = s_connected;
+  s_connected = connected;
+  if (!connected) {
+    if (s_timer) s_parked = true;
+    prv_cancel();
+    return;
+  }
+  if (!was_connected || s_parked) {
+    s_parked = false;
+    s_attempt = 0;
+    prv_arm(RETRY_RECONNECT_MS);
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+#include <pebble.h>
+
+// One backoff loop for everything that talks to the phone. A single timer,
+// exponential delay with jitter per failure kind, parked while disconnected.
+
+typedef void (*RetryHandler)(void);
+
+void retry_init(RetryHandler handler);
+void retry_deinit(void);
+
+// A send failed; try again later according to the policy for `reason`
+void retry_schedule(AppMessageResult reason);
+
+// The phone answered; forget the backoff state
+void retry_reset(void);
+
+// Pause while disconnected; on reconnect fire exactly once
+void retry_set_connected(bool connected);
@@ -0,0 +1,62 @@
+#include <pebble.h>
+#include "scenario.h"
+
+#ifdef HELIOS_SCENARIO
+#include "msg.h"
+#include "stats.h"
+
+#define SCENARIO_SETTLE_MS  2000   // let the restore and first reply land
+#define SCENARIO_REPEAT_MS  180    // same rate as the button repeat in Helios.c
+#define SCENARIO_DAYS       60
+
+// Flaky link: percentages of replies lost and sends bounced with BUSY
+#define FLAKY_DROP_PCT      30
+#define FLAKY_BUSY_PCT      20
+
+static AppTimer *s_timer = NULL;
+static int16_t s_step = 0;
+
+static bool prv_roll(int pct) {
+  return HELIOS_SCENARIO == SCENARIO_FLAKY_LINK && rand() % 100 < pct;
+}
+
+static void prv_step_cb(void *data) {
+  s_timer = NULL;
+  if (s_step >= 2 * SCENARIO_DAYS) {
+    APP_LOG(APP_LOG_LEVEL_INFO, "scenario %d done", HELIOS_SCENARIO);
+    stats_log();
+    return;
+  }
+
+  int32_t delta = s_step < SCENARIO_DAYS ? 1 : -1;
+  s_step++;
+  msg_navigate_to_offset(msg_get_day_offset() + delta);
+  s_timer = app_timer_register(SCENARIO_REPEAT_MS, prv_step_cb, NULL);
+}
+
+void scenario_start(void) {
+  APP_LOG(APP_LOG_LEVEL_INFO, "scenario %d starting", HELIOS_SCENARIO);
+  s_step = 0;
+  s_timer = app_timer_register(SCENARIO_SETTLE_MS, prv_step_cb, NULL);
+}
+
+void scenario_stop(void) {
+  if (s_timer) {
+    app_timer_cancel(s_timer);
+    s_timer = NULL;
+  }
+}
+
+bool scenario_drop_reply(void) {
+  return prv_roll(FLAKY_DROP_PCT);
+}
+
+bool scenario_outbox_busy(void) {
+  return prv_roll(FLAKY_BUSY_PCT);
+}
+
+bool scenario_phone_only(void) {
+  return HELIOS_SCENARIO == SCENARIO_FLAKY_LINK;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+#include <pebble.h>
+
+// Scripted runs for measuring navigation and link behaviour on a watch or
+// the emulator. Build with HELIOS_SCENARIO=<id> in the environment; normal
+// builds compile all of this away.
+#define SCENARIO_HOLD_SCROLL 1   // hold Down for 60 days, then hold Up back
+#define SCENARIO_FLAKY_LINK  2   // same, phone only, with lost replies and a busy outbox
+
+#ifdef HELIOS_SCENARIO
+
+void scenario_start(void);
+void scenario_stop(void);
+
+// Fault injection hooks for msg.c
+bool scenario_drop_reply(void);
+bool scenario_outbox_busy(void);
+bool scenario_phone_only(void);      // every day has to come over the link
+
+#else
+
+static inline void scenario_start(void) {}
+static inline void scenario_stop(void) {}
+static inline bool scenario_drop_reply(void) { return false; }
+static inline bool scenario_outbox_busy(void) { return false; }
+static inline bool scenario_phone_only(void) { return false; }
+
+#endif
@@ -0,0 +1,8 @@
+#pragma once
+
+// Sources shared with the background worker build against its SDK header
+#ifdef HELIOS_WORKER
+  #include <pebble_worker.h>
+#else
+  #include <pebble.h>
+#endif
@@ -0,0 +1,211 @@
+#include "sdk.h"
+#include "solar.h"
+
+// Integer port of SunCalc's getTimes(). Angles are binary turns (2^32 == 360 deg)
+// so wraparound is free; the firmware trig tables take the top 16 bits.
+// Times are milliseconds since J2000 (2000-01-01 12:00 UTC).
+
+#define DAY_MS               86400000LL
+#define J2000_UNIX_S         946728000LL
+#define J0_MS                77760LL        // 0.0009 day
+
+#define MEAN_ANOMALY_0       4265488311u    // 357.5291 deg
+#define MEAN_ANOMALY_Q48     770616155164LL // 0.98560028 deg/day, turns << 48
+#define MEAN_ANOMALY_Q32     11758669LL     // same, turns << 32
+#define CENTER_1             22844454LL     // 1.9148 deg
+#define CENTER_2             238609LL       // 0.02 deg
+#define CENTER_3             3579LL         // 0.0003 deg
+#define PERIHELION           1228088632u    // 102.9372 deg
+#define HALF_TURN            0x80000000u
+
+#define SIN_OBLIQUITY        26069          // sin(23.4397 deg), TRIG_MAX_RATIO scale
+#define TRANSIT_M_MS         457920LL       // 0.0053 day
+#define TRANSIT_2L_MS        596160LL       // 0.0069 day
+
+// Altitudes of the rise/set pairs, TRIG_MAX_RATIO scale
+static const struct {
+  int32_t sin_h;
+  uint8_t rise;
+  uint8_t set;
+} PAIRS[] = {
+  { -20252, SOLAR_ASTRO_DAWN,    SOLAR_ASTRO_DUSK },      // sin(-18 deg)
+  { -13626, SOLAR_NAUTICAL_DAWN, SOLAR_NAUTICAL_DUSK },   // sin(-12 deg)
+  {  -6850, SOLAR_DAWN,          SOLAR_DUSK },            // sin(-6 deg)
+  {  -4571, SOLAR_BLUE_END,      SOLAR_BLUE_START },      // sin(-4 deg)
+  {   -953, SOLAR_SUNRISE,       SOLAR_SUNSET },          // sin(-0.833 deg)
+  {   6850, SOLAR_GOLDEN_END,    SOLAR_GOLDEN_START },    // sin(6 deg)
+};
+
+static int64_t prv_floor_div(int64_t a, int64_t b) {
+  int64_t q = a / b;
+  if ((a % b != 0) && ((a < 0) != (b < 0))) q--;
+  return q;
+}
+
+// Table lookup with linear interpolation on the low 16 bits of the angle
+static int32_t prv_sin(uint32_t turns) {
+  int32_t a = (int32_t)(turns >> 16);
+  int32_t s0 = sin_lookup(a);
+  int32_t s1 = sin_lookup(a + 1);
+  return s0 + (int32_t)(((int64_t)(s1 - s0) * (turns & 0xffff)) >> 16);
+}
+
+static int32_t prv_cos(uint32_t turns) {
+  return prv_sin(turns + (HALF_TURN >> 1));
+}
+
+static uint32_t prv_deg_to_turns(int32_t deg_e6) {
+  return (uint32_t)(((int64_t)deg_e6 << 32) / 360000000LL);
+}
+
+static uint32_t prv_isqrt(uint32_t v) {
+  uint32_t r = 0, bit = 1u << 30;
+  while (bit > v) bit >>= 2;
+  while (bit) {
+    if (v >= r + bit) {
+      v -= r + bit;
+      r = (r >> 1) + bit;
+    } else {
+      r >>= 1;
+    }
+    bit >>= 2;
+  }
+  return r;
+}
+
+// acos of a TRIG_MAX_RATIO-scaled value, in TRIG_MAX_ANGLE units << 16 (half turn max)
+static int64_t prv_acos(int32_t x) {
+  int32_t lo = 0, hi = TRIG_MAX_ANGLE / 2;
+  while (lo < hi) {
+    int32_t mid = (lo + hi) / 2;
+    if (cos_lookup(mid) > x) lo = mid + 1;
+    else hi = mid;
+  }
+  if (lo == 0) return 0;
+  // cos(lo) <= x < cos(lo - 1): interpolate inside the table step
+  int32_t c0 = cos_lookup(lo - 1);
+  int32_t c1 = cos_lookup(lo);
+  int64_t frac = c0 == c1 ? 0 : ((int64_t)(c0 - x) << 16) / (c0 - c1);
+  return ((int64_t)(lo - 1) << 16) + frac;
+}
+
+// Time from transit until the sun reaches sin_h, or -1 if it never does that day
+static int64_t prv_hour_angle_ms(int32_t sin_h, int32_t sin_phi, int32_t cos_phi,
+                                 int32_t sin_dec, int32_t cos_dec) {
+  int64_t num = (int64_t)sin_h * TRIG_MAX_RATIO - (int64_t)sin_phi * sin_dec;
+  int64_t den = (int64_t)cos_phi * cos_dec;
+  if (den <= 0) return -1;
+  int64_t x = num * TRIG_MAX_RATIO / den;
+  if (x < -TRIG_MAX_RATIO || x > TRIG_MAX_RATIO) return -1;
+  return prv_acos((int32_t)x) * DAY_MS / ((int64_t)TRIG_MAX_ANGLE << 16);
+}
+
+static int16_t prv_local_minutes(int32_t utc_offset, int64_t t_ms) {
+  int64_t local_ms = t_ms + (J2000_UNIX_S + utc_offset) * 1000;
+  int64_t m = prv_floor_div(local_ms, 60000) % 1440;
+  if (m < 0) m += 1440;
+  return (int16_t)m;
+}
+
+static void prv_rise_set(int32_t utc_offset, int64_t noon_ms, int64_t w_ms,
+                         int16_t *rise, int16_t *set) {
+  if (w_ms < 0) {
+    *rise = SOLAR_NONE;
+    *set = SOLAR_NONE;
+    return;
+  }
+  *rise = prv_local_minutes(utc_offset, noon_ms - w_ms);
+  *set  = prv_local_minutes(utc_offset, noon_ms + w_ms);
+}
+
+SolarFields solar_fields_clamp(SolarFields fields) {
+  SolarFields out = 0;
+  uint8_t n = 0;
+  for (int f = 0; f < SOLAR_FIELD_COUNT && n < SOLAR_MAX_FIELDS; f++) {
+    if (fields & SOLAR_FIELD(f)) {
+      out |= SOLAR_FIELD(f);
+      n++;
+    }
+  }
+  return out;
+}
+
+uint8_t solar_field_count(SolarFields fields) {
+  uint8_t n = 0;
+  for (int f = 0; f < SOLAR_FIELD_COUNT; f++) {
+    if (fields & SOLAR_FIELD(f)) n++;
+  }
+  return n;
+}
+
+int8_t solar_field_slot(SolarFields fields, SolarField field) {
+  if (!(fields & SOLAR_FIELD(field))) return -1;
+  return (int8_t)solar_field_count(fields & (SOLAR_FIELD(field) - 1));
+}
+
+int16_t solar_get(const SolarDay *day, SolarFields fields, SolarField field) {
+  int8_t slot = solar_field_slot(fields, field);
+  return slot < 0 || slot >= SOLAR_MAX_FIELDS ? SOLAR_NONE : day->minutes[slot];
+}
+
+int32_t solar_offset_at(const SolarLocation *loc, time_t utc) {
+  if (loc->zone_change == SOLAR_ZONE_WATCH) return localtime(&utc)->tm_gmtoff;
+  if (loc->zone_change != SOLAR_ZONE_FIXED && utc >= loc->zone_change) return loc->next_offset;
+  return loc->utc_offset;
+}
+
+int32_t solar_offset_on(const SolarLocation *loc, int32_t local_day) {
+  time_t noon = (time_t)local_day * 86400 + 43200 - loc->utc_offset;
+  return solar_offset_at(loc, noon);
+}
+
+int32_t solar_local_day(const SolarLocation *loc, time_t utc) {
+  return (int32_t)prv_floor_div((int64_t)utc + solar_offset_at(loc, utc), 86400);
+}
+
+void solar_compute_day(const SolarLocation *loc, SolarFields fields, int32_t local_day, SolarDay *out) {
+  int64_t lon_ms = (int64_t)loc->lon_e6 * 6 / 25;   // lon / 360 of a day
+  int32_t utc_offset = solar_offset_on(loc, local_day);
+
+  // Solar cycle whose transit is nearest to local noon (SunCalc's julianCycle)
+  int64_t local_noon_ms = ((int64_t)local_day * 86400 + 43200 - utc_offset - J2000_UNIX_S) * 1000;
+  int64_t n = prv_floor_div(local_noon_ms - J0_MS + lon_ms + DAY_MS / 2, DAY_MS);
+  int64_t transit_ms = J0_MS - lon_ms;
+
+  uint32_t m = MEAN_ANOMALY_0
+             + (uint32_t)((MEAN_ANOMALY_Q48 * n) >> 16)
+             + (uint32_t)(MEAN_ANOMALY_Q32 * transit_ms / DAY_MS);
+  int32_t sin_m = prv_sin(m);
+  uint32_t c = (uint32_t)((CENTER_1 * sin_m
+                         + CENTER_2 * prv_sin(2 * m)
+                         + CENTER_3 * prv_sin(3 * m)) / TRIG_MAX_RATIO);
+  uint32_t l = m + c + PERIHELION + HALF_TURN;
+
+  int32_t sin_dec = SIN_OBLIQUITY * prv_sin(l) / TRIG_MAX_RATIO;
+  int32_t cos_dec = (int32_t)prv_isqrt((uint32_t)TRIG_MAX_RATIO * TRIG_MAX_RATIO
+                                       - (uint32_t)(sin_dec * sin_dec));
+
+  int64_t noon_ms = n * DAY_MS + transit_ms
+                  + TRANSIT_M_MS * sin_m / TRIG_MAX_RATIO
+                  - TRANSIT_2L_MS * prv_sin(2 * l) / TRIG_MAX_RATIO;
+
+  uint32_t phi = prv_deg_to_turns(loc->lat_e6);
+  int32_t sin_phi = prv_sin(phi);
+  int32_t cos_phi = prv_cos(phi);
+
+  int16_t all[SOLAR_FIELD_COUNT];
+  all[SOLAR_NOON] = prv_local_minutes(utc_offset, noon_ms);
+  for (unsigned i = 0; i < ARRAY_LENGTH(PAIRS); i++) {
+    // The hour angle is the expensive part; only solve the pairs in use
+    if (!(fields & (SOLAR_FIELD(PAIRS[i].rise) | SOLAR_FIELD(PAIRS[i].set)))) continue;
+    prv_rise_set(utc_offset, noon_ms,
+                 prv_hour_angle_ms(PAIRS[i].sin_h, sin_phi, cos_phi, sin_dec, cos_dec),
+                 &all[PAIRS[i].rise], &all[PAIRS[i].set]);
+  }
+
+  uint8_t slot = 0;
+  for (int f = 0; f < SOLAR_FIELD_COUNT && slot < SOLAR_MAX_FIELDS; f++) {
+    if (fields & SOLAR_FIELD(f)) out->minutes[slot++] = all[f];
+  }
+  while (slot < SOLAR_MAX_FIELDS) out->minutes[slot++] = SOLAR_NONE;
+}
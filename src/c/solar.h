@@ -0,0 +1,78 @@
+#pragma once
+#include "sdk.h"
+
+// Marker for an event that does not happen on a given day (polar day/night)
+#define SOLAR_NONE ((int16_t)-1)
+
+// zone_change values that are not a time
+#define SOLAR_ZONE_FIXED   0     // utc_offset holds for good, as far as we know
+#define SOLAR_ZONE_WATCH (-1)    // follow the watch's own zone (localtime), day by day
+
+// Where and in which time zone to compute
+typedef struct {
+  int32_t lat_e6;       // latitude in microdegrees, north positive
+  int32_t lon_e6;       // longitude in microdegrees, east positive
+  int32_t utc_offset;   // seconds east of UTC, until zone_change
+  int32_t zone_change;  // UTC seconds the offset next changes (DST), or SOLAR_ZONE_*
+  int32_t next_offset;  // seconds east of UTC from zone_change on
+} SolarLocation;
+
+// Events the engine can compute, in the order they happen through the day
+typedef enum {
+  SOLAR_ASTRO_DAWN,      // -18 deg
+  SOLAR_NAUTICAL_DAWN,   // -12 deg
+  SOLAR_DAWN,            // civil, -6 deg
+  SOLAR_BLUE_END,        // -4 deg; the morning blue hour starts at civil dawn
+  SOLAR_SUNRISE,         // -0.833 deg
+  SOLAR_GOLDEN_END,      // +6 deg; the morning golden hour starts at sunrise
+  SOLAR_NOON,
+  SOLAR_GOLDEN_START,    // +6 deg
+  SOLAR_SUNSET,
+  SOLAR_BLUE_START,      // -4 deg
+  SOLAR_DUSK,            // civil, -6 deg
+  SOLAR_NAUTICAL_DUSK,
+  SOLAR_ASTRO_DUSK,
+  SOLAR_FIELD_COUNT
+} SolarField;
+
+// Bitmask of SolarFields; a record holds only the ones set, in field order
+typedef uint16_t SolarFields;
+
+#define SOLAR_FIELD(f)        ((SolarFields)(1u << (f)))
+#define SOLAR_FIELDS_ALL      ((SolarFields)((1u << SOLAR_FIELD_COUNT) - 1))
+#define SOLAR_FIELDS_CLASSIC  (SOLAR_FIELD(SOLAR_DAWN) | SOLAR_FIELD(SOLAR_SUNRISE) | \
+                               SOLAR_FIELD(SOLAR_SUNSET) | SOLAR_FIELD(SOLAR_DUSK))
+
+// Most fields one record holds; sized for the rows the screen can show
+#define SOLAR_MAX_FIELDS 5
+
+// Event times as minutes since local midnight, or SOLAR_NONE. Slot i is the
+// i-th field set in the record's mask; unused slots are SOLAR_NONE.
+typedef struct {
+  int16_t minutes[SOLAR_MAX_FIELDS];
+} SolarDay;
+
+// Drop anything past the first SOLAR_MAX_FIELDS set fields (and unknown bits)
+SolarFields solar_fields_clamp(SolarFields fields);
+uint8_t solar_field_count(SolarFields fields);
+
+// Slot of a field in records with this mask, or -1 if it is not in it
+int8_t solar_field_slot(SolarFields fields, SolarField field);
+
+// Minutes for one field of a record, SOLAR_NONE if the mask leaves it out
+int16_t solar_get(const SolarDay *day, SolarFields fields, SolarField field);
+
+// UTC offset in effect at a UTC timestamp
+int32_t solar_offset_at(const SolarLocation *loc, time_t utc);
+
+// UTC offset in effect on a local calendar day; zones change at night, so
+// this is the one at local noon
+int32_t solar_offset_on(const SolarLocation *loc, int32_t local_day);
+
+// Local calendar day (days since 1970-01-01 in the location's zone) containing a UTC timestamp
+int32_t solar_local_day(const SolarLocation *loc, time_t utc);
+
+// Compute the fields in `fields` for a local calendar day, in minutes of the
+// offset in effect that day. Integer-only; follows SunCalc's model. Pairs of
+// events nobody asked for are skipped.
+void solar_compute_day(const SolarLocation *loc, SolarFields fields, int32_t local_day, SolarDay *out);
@@ -0,0 +1,61 @@
+#include <pebble.h>
+#include "stats.h"
+#include "cache.h"
+#include "probe.h"
+
+static uint32_t s_counters[STAT_COUNT];
+
+static uint32_t s_press_ms = 0;      // 0 while no press is waiting for a paint
+static uint32_t s_paints = 0;
+static uint32_t s_latency_sum_ms = 0;
+static uint32_t s_latency_max_ms = 0;
+
+// Wraps after ~49 days, which is fine for differences within one session
+static uint32_t prv_now_ms(void) {
+  time_t s;
+  uint16_t ms = time_ms(&s, NULL);
+  return (uint32_t)s * 1000 + ms;
+}
+
+void stats_count(StatCounter c) {
+  s_counters[c]++;
+}
+
+uint32_t stats_get(StatCounter c) {
+  return s_counters[c];
+}
+
+void stats_mark_press(void) {
+  // Keep the earliest unpainted press; that is the one the user is waiting on
+  if (!s_press_ms) s_press_ms = prv_now_ms() | 1;
+}
+
+void stats_mark_paint(void) {
+  if (!s_press_ms) return;
+  uint32_t dt = prv_now_ms() - s_press_ms;
+  s_press_ms = 0;
+
+  PROBE_RECORD(PROBE_PRESS_TO_PAINT, dt);
+  s_paints++;
+  s_latency_sum_ms += dt;
+  if (dt > s_latency_max_ms) s_latency_max_ms = dt;
+}
+
+void stats_log(void) {
+  const CacheStats *cache = cache_get_stats();
+  uint32_t lookups = cache->hits + cache->misses;
+  uint32_t navs = s_counters[STAT_NAV];
+
+  APP_LOG(APP_LOG_LEVEL_INFO, "cache: %d hits, %d misses, %d%% (width %d)",
+          (int)cache->hits, (int)cache->misses,
+          lookups ? (int)(cache->hits * 100 / lookups) : 0, cache_width());
+  APP_LOG(APP_LOG_LEVEL_INFO, "nav: %d, req: %d (%d.%02d/nav), replies: %d (%d patches), retries: %d, dropped: %d",
+          (int)navs, (int)s_counters[STAT_REQ_SENT],
+          navs ? (int)(s_counters[STAT_REQ_SENT] / navs) : 0,
+          navs ? (int)(s_counters[STAT_REQ_SENT] * 100 / navs % 100) : 0,
+          (int)s_counters[STAT_REPLY], (int)s_counters[STAT_PATCH], (int)s_counters[STAT_RETRY],
+          (int)s_counters[STAT_DROPPED]);
+  APP_LOG(APP_LOG_LEVEL_INFO, "press->paint: %d samples, avg %d ms, max %d ms",
+          (int)s_paints, s_paints ? (int)(s_latency_sum_ms / s_paints) : 0,
+          (int)s_latency_max_ms);
+}
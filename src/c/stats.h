@@ -0,0 +1,23 @@
+#pragma once
+#include <pebble.h>
+
+// Cheap always-on counters, dumped to the log when the app exits so
+// performance changes can be compared run against run.
+typedef enum {
+  STAT_NAV,          // day changes asked for by the user (or a scenario)
+  STAT_REQ_SENT,     // REQs handed to the outbox
+  STAT_REPLY,        // replies that completed a REQ
+  STAT_RETRY,        // retries scheduled after a failure
+  STAT_DROPPED,      // replies thrown away by fault injection
+  STAT_PATCH,        // replies applied as a patch rather than a bundle
+  STAT_COUNT
+} StatCounter;
+
+void stats_count(StatCounter c);
+uint32_t stats_get(StatCounter c);
+
+// Press-to-paint latency: a press starts the clock, the next paint stops it
+void stats_mark_press(void);
+void stats_mark_paint(void);
+
+void stats_log(void);
@@ -0,0 +1,103 @@
+#include "sdk.h"
+#include "store.h"
+
+#define STORE_VERSION 4
+
+// ~1 km; well under what it takes to move an event by a minute
+#define STORE_LOC_EPSILON_E6 10000
+
+#define STORE_HEADER_SIZE 30
+#define STORE_SLOTS ((PERSIST_DATA_MAX_LENGTH - STORE_HEADER_SIZE) / sizeof(int16_t))
+
+// On-flash layout. Bump STORE_VERSION whenever this changes. Days are packed
+// back to back, each holding only the enabled fields.
+typedef struct __attribute__((packed)) {
+  uint8_t version;
+  uint8_t count;
+  uint16_t sync_epoch;
+  uint16_t fields;
+  int32_t lat_e6;
+  int32_t lon_e6;
+  int32_t utc_offset;
+  int32_t zone_change;
+  int32_t next_offset;
+  int32_t first_day;
+  int16_t minutes[STORE_SLOTS];
+} StoreRecord;
+
+_Static_assert(offsetof(StoreRecord, minutes) == STORE_HEADER_SIZE, "StoreRecord header size");
+_Static_assert(sizeof(StoreRecord) <= PERSIST_DATA_MAX_LENGTH, "StoreRecord exceeds persist limit");
+
+bool store_same_location(const SolarLocation *a, const SolarLocation *b) {
+  return a->utc_offset == b->utc_offset
+      && a->zone_change == b->zone_change && a->next_offset == b->next_offset
+      && abs(a->lat_e6 - b->lat_e6) <= STORE_LOC_EPSILON_E6
+      && abs(a->lon_e6 - b->lon_e6) <= STORE_LOC_EPSILON_E6;
+}
+
+bool store_load(StoreSnapshot *out) {
+  StoreRecord rec;
+  if (!persist_exists(PERSIST_KEY_DAYS)) return false;
+  int read = persist_read_data(PERSIST_KEY_DAYS, &rec, sizeof(rec));
+  if (read < STORE_HEADER_SIZE) return false;
+  uint8_t n = solar_field_count(rec.fields);
+  // A record cut short (or written by another layout) would leave days unread
+  if (rec.version != STORE_VERSION || rec.count > STORE_MAX_DAYS || !n ||
+      rec.fields != solar_fields_clamp(rec.fields) || rec.count * n > STORE_SLOTS ||
+      read < (int)(STORE_HEADER_SIZE + rec.count * n * sizeof(int16_t))) {
+    persist_delete(PERSIST_KEY_DAYS);
+    return false;
+  }
+
+  out->loc.lat_e6 = rec.lat_e6;
+  out->loc.lon_e6 = rec.lon_e6;
+  out->loc.utc_offset = rec.utc_offset;
+  out->loc.zone_change = rec.zone_change;
+  out->loc.next_offset = rec.next_offset;
+  out->sync_epoch = rec.sync_epoch;
+  out->fields = rec.fields;
+
+  // Drop days that are already behind us
+  int32_t today = solar_local_day(&out->loc, time(NULL));
+  int skip = today > rec.first_day ? today - rec.first_day : 0;
+  if (skip > rec.count) skip = rec.count;
+
+  out->first_day = rec.first_day + skip;
+  out->count = rec.count - skip;
+  for (int i = 0; i < out->count; i++) {
+    for (int f = 0; f < SOLAR_MAX_FIELDS; f++) {
+      out->days[i].minutes[f] = f < n ? rec.minutes[(i + skip) * n + f] : SOLAR_NONE;
+    }
+  }
+  // The location is still worth keeping even if every day has expired
+  return true;
+}
+
+void store_save(const StoreSnapshot *snap) {
+  uint8_t n = solar_field_count(snap->fields);
+  if (!n) return;
+  uint8_t fit = STORE_SLOTS / n;
+  if (fit > STORE_MAX_DAYS) fit = STORE_MAX_DAYS;
+
+  StoreRecord rec = {
+    .version = STORE_VERSION,
+    .count = snap->count > fit ? fit : snap->count,
+    .sync_epoch = snap->sync_epoch,
+    .fields = snap->fields,
+    .lat_e6 = snap->loc.lat_e6,
+    .lon_e6 = snap->loc.lon_e6,
+    .utc_offset = snap->loc.utc_offset,
+    .zone_change = snap->loc.zone_change,
+    .next_offset = snap->loc.next_offset,
+    .first_day = snap->first_day,
+  };
+  for (int i = 0; i < rec.count; i++) {
+    memcpy(&rec.minutes[i * n], snap->days[i].minutes, n * sizeof(int16_t));
+  }
+  size_t size = offsetof(StoreRecord, minutes) + rec.count * n * sizeof(int16_t);
+  persist_write_data(PERSIST_KEY_DAYS, &rec, size);
+}
+
+void store_clear(void) {
+  persist_delete(PERSIST_KEY_DAYS);
+}
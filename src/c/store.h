@@ -0,0 +1,38 @@
+#pragma once
+#include "sdk.h"
+#include "solar.h"
+
+// Persist keys owned by the app
+enum {
+  PERSIST_KEY_DAYS = 1,
+  PERSIST_KEY_PROBES = 2,   // debug histogram, probe builds only
+  PERSIST_KEY_WORKER = 3,   // WorkerReport, written by the background worker
+  PERSIST_KEY_PLACES = 4,   // saved locations from the phone
+  PERSIST_KEY_PLACE_ACTIVE = 5,
+  PERSIST_KEY_FIELDS = 6,   // SolarFields the user picked on the phone
+  PERSIST_KEY_WORKER_ON = 7,  // user opted in to the background worker
+};
+
+// Most days kept on flash. Fewer fit when more fields are enabled: one
+// record has to fit in PERSIST_DATA_MAX_LENGTH.
+#define STORE_MAX_DAYS 28
+
+// A run of consecutive days, tagged with where and when it was computed
+typedef struct {
+  SolarLocation loc;
+  int32_t first_day;      // local day (days since epoch) of days[0]
+  uint16_t sync_epoch;    // phone's cache epoch these days match, 0 if unknown
+  SolarFields fields;     // what each of days[] holds
+  uint8_t count;
+  SolarDay days[STORE_MAX_DAYS];
+} StoreSnapshot;
+
+// Load the persisted days, dropping anything before today. False if nothing usable.
+bool store_load(StoreSnapshot *out);
+
+// Save as many days as fit for the snapshot's fields
+void store_save(const StoreSnapshot *snap);
+void store_clear(void);
+
+// True if two locations are close enough to share cached times
+bool store_same_location(const SolarLocation *a, const SolarLocation *b);
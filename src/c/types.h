@@ -1,12 +1,9 @@
 #pragma once
 #include <pebble.h>
+#include "solar.h"
 
 typedef struct {
   bool valid;
-  int32_t offset;
-  char date[20];    // e.g., "Wed Sep 03"
-  char dawn[6];     // "HH:MM"
-  char sunrise[6];
-  char sunset[6];
-  char dusk[6];
+  int32_t day;      // local calendar day, days since 1970-01-01
+  SolarDay times;   // minutes since local midnight, SOLAR_NONE if absent
 } DayTimes;
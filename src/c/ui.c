@@ -1,181 +1,285 @@
 #include <pebble.h>
 #include "ui.h"
 #include "types.h"
+#include "stats.h"
+#include "probe.h"
+#include "fields.h"
+#include "lowmem.h"
+
+// Final rectangles for this platform, generated from src/layout.json by wscript
+#include "src/layout_table.auto.h"
 
 // Window and layers
 static Window *s_main_window;
 
 static TextLayer *s_text_layer;       // status overlay
-static TextLayer *s_date_layer;       // date line
-static TextLayer *s_times_layer;      // LECO numbers (times)
-static Layer     *s_labels_layer;     // custom-drawn labels (baseline-aligned)
+static char s_status_buf[48];         // formatted status text, the only one
+static Layer     *s_content_layer;    // date, labels and times, all drawn by hand
+
+_Static_assert(LAYOUT_COMPACT_ROWS >= SOLAR_MAX_FIELDS, "layout.json has fewer compact rows than a record holds");
 
 // Fonts
 static GFont s_font_date;
 static GFont s_font_labels;
 static GFont s_font_times;
 
-// Metrics for baseline alignment
-static int16_t s_leco_line_h = 0;     // measured row height from LECO
-static int16_t s_label_h[4] = {0};
-static int8_t  s_label_baseline_nudge = 0;
+// Rows we draw: one per enabled field, regular or compact rectangles
+static uint8_t s_rows = 0;
+static bool s_compact = false;
+static const char *s_labels[SOLAR_MAX_FIELDS];
 
-// Labels we draw
-static const char *LABELS[4] = {"Dawn", "Sunrise", "Sunset", "Dusk"};
-
-// Percent-based layout (per platform tuned)
+// What is on screen, plus the day it is sliding away from. Rows are only
+// re-formatted when their minute changes, and nothing is marked dirty when a
+// day looks the same as the last one.
+#define ROW_UNSET INT16_MIN
 typedef struct {
-  uint8_t margin_h_pct;    // left/right
-  uint8_t margin_top_pct;  // top
-  uint8_t margin_bot_pct;  // bottom
-  uint8_t label_col_pct;   // of content width
-  uint8_t col_gap_pct;     // of content width
-  uint8_t row_gap_pct;     // of full height
-  int8_t  times_nudge_pct; // of content width (left negative)
-  int8_t  times_nudge_px;  // absolute pixel nudge
-  const char *font_key_date;
-  const char *font_key_labels;
-  const char *font_key_times;
-} LayoutParams;
-
-static LayoutParams s_lp;
-
-static int16_t prv_measure_text_h(const char *text, GFont font, int16_t width, GTextOverflowMode overflow) {
-  GRect box = GRect(0, 0, width, 2000);
-  GSize sz = graphics_text_layout_get_content_size(text, font, box, overflow, GTextAlignmentLeft);
-  return sz.h;
-}
-
-static void prv_compute_platform_params(void) {
-  // Defaults for Aplite/Basalt/Diorite (144x168 baseline)
-  s_lp.margin_h_pct   = 6;
-  s_lp.margin_top_pct = 7;
-  s_lp.margin_bot_pct = 6;
-  s_lp.label_col_pct  = 42; // ~54 px of ~128 content width
-  s_lp.col_gap_pct    = 5;  // ~6 px
-  s_lp.row_gap_pct    = 3;
-  s_lp.times_nudge_pct= 0;
-  s_lp.times_nudge_px = -6;
-  s_lp.font_key_date   = FONT_KEY_GOTHIC_24_BOLD;
-  s_lp.font_key_labels = FONT_KEY_GOTHIC_24;
-  s_lp.font_key_times  = FONT_KEY_LECO_26_BOLD_NUMBERS_AM_PM;
-
-  // Chalk (round)
-  #if defined(PBL_PLATFORM_CHALK)
-    s_lp.margin_h_pct   = 9;
-    s_lp.margin_top_pct = 8;
-    s_lp.margin_bot_pct = 8;
-    s_lp.label_col_pct  = 44;
-    s_lp.col_gap_pct    = 5;
-    s_lp.row_gap_pct    = 3;
-    s_lp.times_nudge_pct= -2;
-    s_lp.times_nudge_px = 0;
-    s_lp.font_key_date   = FONT_KEY_GOTHIC_24_BOLD;
-    s_lp.font_key_labels = FONT_KEY_GOTHIC_18;
-    s_lp.font_key_times  = FONT_KEY_LECO_20_BOLD_NUMBERS;
-  #endif
-
-  // Emery (200x228)
-  #if defined(PBL_PLATFORM_EMERY)
-    s_lp.margin_h_pct   = 6;
-    s_lp.margin_top_pct = 6;
-    s_lp.margin_bot_pct = 6;
-    s_lp.label_col_pct  = 38;
-    s_lp.col_gap_pct    = 4;
-    s_lp.row_gap_pct    = 3;
-    s_lp.times_nudge_pct= -2;
-    s_lp.times_nudge_px = -2;
-    s_lp.font_key_date   = FONT_KEY_GOTHIC_28_BOLD;
-    s_lp.font_key_labels = FONT_KEY_GOTHIC_24;
-    s_lp.font_key_times  = FONT_KEY_LECO_32_BOLD_NUMBERS;
-  #endif
-}
+  int32_t day;
+  int16_t min[SOLAR_MAX_FIELDS];
+  char date[20];
+  char time[SOLAR_MAX_FIELDS][6];
+} DayPane;
+
+static DayPane s_panes[2] = { { .day = INT32_MIN }, { .day = INT32_MIN } };
+static uint8_t s_front = 0;           // pane on screen, or sliding in
+static bool s_have_day = false;
+
+// Day-to-day slide. Each day is drawn once and copied out of the frame buffer;
+// every frame after that is row copies, so a held button scrolls at full rate.
+// Sized to end inside the 180 ms repeat of a held button.
+#define SLIDE_MS 150
+#if defined(PBL_BW)
+  #define SLIDE_BPP 1
+#else
+  #define SLIDE_BPP 8
+#endif
+
+static struct {
+  uint8_t *buf[2];          // content rows of each day, SLIDE_BPP like the frame buffer
+  uint16_t first;           // first frame buffer byte of a content row
+  uint16_t span;            // bytes per content row
+  uint16_t rows;
+  uint8_t in;               // buf[] index of the incoming day
+  bool out_ready, in_ready; // buffers hold the current panes
+  int8_t direction;         // > 0: later day comes up from below
+  int8_t pending;           // direction for the next day shown, 0 for none
+  bool disabled;            // the frame buffer is not in a format we copy
+  AnimationProgress progress;
+  Animation *anim;
+} s_slide;
+
+// Text shown in place of the date for a moment (e.g. after switching place)
+#define TITLE_FLASH_MS 1500
+static const char *s_title = NULL;
+static AppTimer *s_title_timer = NULL;
 
 static void prv_apply_fonts(void) {
-  s_font_date   = fonts_get_system_font(s_lp.font_key_date);
-  s_font_labels = fonts_get_system_font(s_lp.font_key_labels);
-  s_font_times  = fonts_get_system_font(s_lp.font_key_times);
-  if (s_date_layer)  text_layer_set_font(s_date_layer, s_font_date);
-  if (s_times_layer) text_layer_set_font(s_times_layer, s_font_times);
+  s_font_date   = fonts_get_system_font(LAYOUT_FONT_DATE);
+  s_font_labels = fonts_get_system_font(s_compact ? LAYOUT_FONT_LABELS_COMPACT : LAYOUT_FONT_LABELS);
+  s_font_times  = fonts_get_system_font(s_compact ? LAYOUT_FONT_TIMES_COMPACT : LAYOUT_FONT_TIMES);
 }
 
-static void prv_labels_update_proc(Layer *layer, GContext *ctx) {
+static void prv_draw_pane(GContext *ctx, const DayPane *pane, const char *title) {
   graphics_context_set_text_color(ctx, GColorWhite);
-  GRect bounds = layer_get_bounds(layer);
-  int16_t row_h = s_leco_line_h > 0 ? s_leco_line_h : 24;
 
-  for (int i = 0; i < 4; i++) {
-    int16_t label_h = s_label_h[i] > 0 ? s_label_h[i] : 18;
-    int16_t row_top = i * row_h;
-    int16_t row_bottom = row_top + row_h;
-
-    GRect r = GRect(0, row_bottom - label_h + s_label_baseline_nudge,
-                    bounds.size.w, label_h);
-    graphics_draw_text(ctx, LABELS[i], s_font_labels, r,
+  graphics_draw_text(ctx, title ? title : pane->date, s_font_date, LAYOUT_DATE, GTextOverflowModeWordWrap,
+                     PBL_IF_ROUND_ELSE(GTextAlignmentCenter, GTextAlignmentLeft), NULL);
+  const GRect *labels = s_compact ? LAYOUT_COMPACT_LABEL : LAYOUT_LABEL;
+  const GRect *times = s_compact ? LAYOUT_COMPACT_TIME : LAYOUT_TIME;
+  for (int i = 0; i < s_rows; i++) {
+    graphics_draw_text(ctx, s_labels[i], s_font_labels, labels[i],
                        GTextOverflowModeWordWrap, GTextAlignmentLeft, NULL);
+    graphics_draw_text(ctx, pane->time[i], s_font_times, times[i],
+                       GTextOverflowModeFill, GTextAlignmentLeft, NULL);
   }
 }
 
-static void prv_recalc_metrics_and_redraw(void) {
-  if (!s_main_window || !s_times_layer || !s_labels_layer) return;
-
-  GRect times_frame = layer_get_frame(text_layer_get_layer(s_times_layer));
-  s_leco_line_h = prv_measure_text_h("88:88", s_font_times, times_frame.size.w, GTextOverflowModeFill);
+// Bytes of frame buffer row y under the content layer, clipped to what the
+// row actually has (rows on round displays are shorter). False if none.
+static bool prv_row_span(GBitmap *fb, int y, uint8_t **data, int *lo, int *hi) {
+  GBitmapDataRowInfo info = gbitmap_get_data_row_info(fb, y);
+  *data = info.data;
+  *lo = info.min_x * SLIDE_BPP / 8;
+  *hi = info.max_x * SLIDE_BPP / 8;
+  if (*lo < s_slide.first) *lo = s_slide.first;
+  if (*hi > s_slide.first + s_slide.span - 1) *hi = s_slide.first + s_slide.span - 1;
+  return *lo <= *hi;
+}
 
-  GRect labels_frame = layer_get_frame(s_labels_layer);
-  s_label_h[0] = prv_measure_text_h("Dawn",    s_font_labels, labels_frame.size.w, GTextOverflowModeWordWrap);
-  s_label_h[1] = prv_measure_text_h("Sunrise", s_font_labels, labels_frame.size.w, GTextOverflowModeWordWrap);
-  s_label_h[2] = prv_measure_text_h("Sunset",  s_font_labels, labels_frame.size.w, GTextOverflowModeWordWrap);
-  s_label_h[3] = prv_measure_text_h("Dusk",    s_font_labels, labels_frame.size.w, GTextOverflowModeWordWrap);
+static bool prv_slide_fb_ok(GBitmap *fb) {
+  GBitmapFormat format = gbitmap_get_format(fb);
+  return SLIDE_BPP == 1 ? format == GBitmapFormat1Bit
+                        : format == GBitmapFormat8Bit || format == GBitmapFormat8BitCircular;
+}
 
-  layer_mark_dirty(s_labels_layer);
+// Draw a pane and keep a copy of its rows
+static bool prv_slide_grab(Layer *layer, GContext *ctx, const DayPane *pane, const char *title, uint8_t *buf) {
+  GRect frame = layer_get_frame(layer);
+  graphics_context_set_fill_color(ctx, GColorBlack);
+  graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+  prv_draw_pane(ctx, pane, title);
+
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if (!fb) return false;
+  bool ok = prv_slide_fb_ok(fb);
+  for (int y = 0; ok && y < s_slide.rows; y++) {
+    uint8_t *data;
+    int lo, hi;
+    if (prv_row_span(fb, frame.origin.y + y, &data, &lo, &hi)) {
+      memcpy(buf + y * s_slide.span + lo - s_slide.first, data + lo, hi - lo + 1);
+    }
+  }
+  graphics_release_frame_buffer(ctx, fb);
+  return ok;
 }
 
-static void prv_layout_layers(void) {
-  if (!s_main_window) return;
+// One animation frame: both days' rows, offset by how far along the slide is
+static bool prv_slide_draw(Layer *layer, GContext *ctx) {
+  if (!s_slide.out_ready) {
+    if (!prv_slide_grab(layer, ctx, &s_panes[s_front ^ 1], NULL, s_slide.buf[s_slide.in ^ 1])) return false;
+    s_slide.out_ready = true;
+  }
+  if (!s_slide.in_ready) {
+    if (!prv_slide_grab(layer, ctx, &s_panes[s_front], s_title, s_slide.buf[s_slide.in])) return false;
+    s_slide.in_ready = true;
+  }
 
-  Layer *window_layer = window_get_root_layer(s_main_window);
-  GRect bounds = layer_get_bounds(window_layer);
+  int h = s_slide.rows;
+  AnimationProgress progress = s_slide.progress;
+  if (progress > ANIMATION_NORMALIZED_MAX) progress = ANIMATION_NORMALIZED_MAX;
+  if (progress < 0) progress = 0;
+  int offset = (int)((int64_t)h * progress / ANIMATION_NORMALIZED_MAX);
+  const uint8_t *out = s_slide.buf[s_slide.in ^ 1];
+  const uint8_t *in = s_slide.buf[s_slide.in];
+
+  GBitmap *fb = graphics_capture_frame_buffer(ctx);
+  if (!fb) return false;
+  int top = layer_get_frame(layer).origin.y;
+  for (int y = 0; y < h; y++) {
+    // Down moves everything up, the later day rising in under the current one
+    int src = s_slide.direction > 0 ? y + offset : y - offset;
+    const uint8_t *row = src >= h ? in + (src - h) * s_slide.span
+                       : src < 0  ? in + (src + h) * s_slide.span
+                       : out + src * s_slide.span;
+    uint8_t *data;
+    int lo, hi;
+    if (prv_row_span(fb, top + y, &data, &lo, &hi)) {
+      memcpy(data + lo, row + lo - s_slide.first, hi - lo + 1);
+    }
+  }
+  graphics_release_frame_buffer(ctx, fb);
+  return true;
+}
 
-  prv_compute_platform_params();
-  prv_apply_fonts();
+static void prv_slide_update(Animation *anim, const AnimationProgress progress) {
+  s_slide.progress = progress;
+  if (s_content_layer) layer_mark_dirty(s_content_layer);
+}
 
-  int16_t margin_x   = (bounds.size.w * s_lp.margin_h_pct) / 100;
-  int16_t margin_top = (bounds.size.h * s_lp.margin_top_pct) / 100;
-  int16_t margin_bot = (bounds.size.h * s_lp.margin_bot_pct) / 100;
+static void prv_slide_stopped(Animation *anim, bool finished, void *context) {
+  // An interrupted slide may report in after its replacement was scheduled
+  if (anim != s_slide.anim) return;
+  s_slide.anim = NULL;
+  if (s_content_layer) layer_mark_dirty(s_content_layer);
+}
 
-  int16_t content_x = margin_x;
-  int16_t content_y = margin_top;
-  int16_t content_w = bounds.size.w - margin_x - margin_x;
-  int16_t content_h = bounds.size.h - margin_top - margin_bot;
+static const AnimationImplementation s_slide_impl = {
+  .update = prv_slide_update,
+};
 
-  int16_t date_w = content_w;
-  int16_t row_gap_px = (bounds.size.h * s_lp.row_gap_pct) / 100;
-  if (row_gap_px < 1) row_gap_px = 1;
+static void prv_slide_stop(void) {
+  Animation *anim = s_slide.anim;
+  s_slide.anim = NULL;
+  if (anim) animation_unschedule(anim);
+}
 
-  int16_t date_h = prv_measure_text_h("Wed Sep 30", s_font_date, date_w, GTextOverflowModeWordWrap);
-  GRect date_frame = GRect(content_x, content_y, date_w, date_h);
+static void prv_slide_free(void) {
+  prv_slide_stop();
+  for (int i = 0; i < 2; i++) {
+    free(s_slide.buf[i]);
+    s_slide.buf[i] = NULL;
+  }
+}
 
-  int16_t labels_w = (content_w * s_lp.label_col_pct) / 100;
-  int16_t gap_w    = (content_w * s_lp.col_gap_pct) / 100;
+// Buffers for the content layer's rows, allocated on the first slide
+static bool prv_slide_buffers(void) {
+  if (s_slide.buf[0] && s_slide.buf[1]) return true;
+  // The low-memory profile keeps this heap for messages and the cache
+  if (!s_content_layer || s_slide.disabled || lowmem_active()) return false;
+
+  GRect frame = layer_get_frame(s_content_layer);
+  s_slide.first = frame.origin.x * SLIDE_BPP / 8;
+  s_slide.span = ((frame.origin.x + frame.size.w) * SLIDE_BPP + 7) / 8 - s_slide.first;
+  s_slide.rows = frame.size.h;
+  for (int i = 0; i < 2; i++) {
+    if (!s_slide.buf[i]) s_slide.buf[i] = malloc(s_slide.span * s_slide.rows);
+  }
+  if (s_slide.buf[0] && s_slide.buf[1]) return true;
+  // Not enough heap for both; days just swap in place
+  prv_slide_free();
+  return false;
+}
 
-  int16_t rows_y = content_y + date_h + row_gap_px;
-  int16_t rows_h = content_h - date_h - row_gap_px;
+// Move the shown day to the back pane and start sliding a new one over it.
+// False if there is no memory for it; the caller then updates in place.
+static bool prv_slide_begin(int8_t direction) {
+  if (!prv_slide_buffers()) return false;
+
+  // Interrupted mid-slide: the day that was coming in is already drawn and
+  // becomes the one going out, so only the new day has to be rendered
+  bool reuse = s_slide.anim && s_slide.in_ready;
+  prv_slide_stop();
+  if (reuse) s_slide.in ^= 1;
+  s_slide.out_ready = reuse;
+  s_slide.in_ready = false;
+
+  s_panes[s_front ^ 1] = s_panes[s_front];
+  s_front ^= 1;
+  s_slide.direction = direction;
+  s_slide.progress = 0;
+
+  Animation *anim = animation_create();
+  if (!anim) return true;   // panes are swapped; shown without the slide
+  animation_set_duration(anim, SLIDE_MS);
+  animation_set_curve(anim, AnimationCurveEaseOut);
+  animation_set_implementation(anim, &s_slide_impl);
+  animation_set_handlers(anim, (AnimationHandlers) { .stopped = prv_slide_stopped }, NULL);
+  s_slide.anim = anim;
+  animation_schedule(anim);
+  return true;
+}
 
-  GRect labels_frame = GRect(content_x, rows_y, labels_w, rows_h);
+static void prv_content_update_proc(Layer *layer, GContext *ctx) {
+  if (!s_have_day) return;
+  PROBE_START(t_draw);
+  if (s_slide.anim && !prv_slide_draw(layer, ctx)) {
+    // No frame buffer access on this display; stop trying, and clear
+    // whatever was drawn for the copies
+    s_slide.disabled = true;
+    prv_slide_free();
+    graphics_context_set_fill_color(ctx, GColorBlack);
+    graphics_fill_rect(ctx, layer_get_bounds(layer), 0, GCornerNone);
+  }
+  if (!s_slide.anim) prv_draw_pane(ctx, &s_panes[s_front], s_title);
+  PROBE_STOP(PROBE_DRAW, t_draw);
+}
 
-  int16_t times_nudge = (content_w * s_lp.times_nudge_pct) / 100 + s_lp.times_nudge_px;
-  int16_t times_x = content_x + labels_w + gap_w + times_nudge;
-  int16_t times_w = (content_x + content_w) - times_x;
-  if (times_w < 10) times_w = 10;
-  GRect times_frame = GRect(times_x, rows_y, times_w, rows_h);
+// The incoming day changed under a running slide; draw it again next frame
+static void prv_content_changed(void) {
+  s_slide.in_ready = false;
+  if (s_content_layer) layer_mark_dirty(s_content_layer);
+}
+
+static void prv_layout_layers(void) {
+  if (!s_main_window) return;
 
-  if (s_date_layer)    layer_set_frame(text_layer_get_layer(s_date_layer), date_frame);
-  if (s_labels_layer)  layer_set_frame(s_labels_layer, labels_frame);
-  if (s_times_layer)   layer_set_frame(text_layer_get_layer(s_times_layer), times_frame);
-  if (s_text_layer)    layer_set_frame(text_layer_get_layer(s_text_layer), bounds);
+  Layer *window_layer = window_get_root_layer(s_main_window);
+  prv_apply_fonts();
 
-  prv_recalc_metrics_and_redraw();
+  if (s_content_layer) {
+    layer_set_frame(s_content_layer, LAYOUT_CONTENT);
+    layer_mark_dirty(s_content_layer);
+  }
+  if (s_text_layer) layer_set_frame(text_layer_get_layer(s_text_layer), layer_get_bounds(window_layer));
 }
 
 // Public API
@@ -186,32 +290,10 @@ void ui_init(Window *window) {
   GRect bounds = layer_get_bounds(window_layer);
   window_set_background_color(window, GColorBlack);
 
-  // Date
-  s_date_layer = text_layer_create(bounds);
-  text_layer_set_background_color(s_date_layer, GColorBlack);
-  text_layer_set_text_color(s_date_layer, GColorWhite);
-  text_layer_set_text_alignment(s_date_layer,
-    #if defined(PBL_ROUND)
-      GTextAlignmentCenter
-    #else
-      GTextAlignmentLeft
-    #endif
-  );
-  text_layer_set_overflow_mode(s_date_layer, GTextOverflowModeWordWrap);
-  layer_add_child(window_layer, text_layer_get_layer(s_date_layer));
-
-  // Labels (custom draw for baseline alignment)
-  s_labels_layer = layer_create(bounds);
-  layer_set_update_proc(s_labels_layer, prv_labels_update_proc);
-  layer_add_child(window_layer, s_labels_layer);
-
-  // Times (LECO)
-  s_times_layer = text_layer_create(bounds);
-  text_layer_set_background_color(s_times_layer, GColorBlack);
-  text_layer_set_text_color(s_times_layer, GColorWhite);
-  text_layer_set_text_alignment(s_times_layer, GTextAlignmentLeft);
-  text_layer_set_overflow_mode(s_times_layer, GTextOverflowModeFill);
-  layer_add_child(window_layer, text_layer_get_layer(s_times_layer));
+  // Content
+  s_content_layer = layer_create(bounds);
+  layer_set_update_proc(s_content_layer, prv_content_update_proc);
+  layer_add_child(window_layer, s_content_layer);
 
   // Status overlay
   s_text_layer = text_layer_create(bounds);
@@ -229,19 +311,32 @@ void ui_init(Window *window) {
   text_layer_set_font(s_text_layer, fonts_get_system_font(FONT_KEY_GOTHIC_24));
   layer_add_child(window_layer, text_layer_get_layer(s_text_layer));
 
+  ui_set_fields(SOLAR_FIELDS_CLASSIC);
   prv_layout_layers();
 }
 
 void ui_deinit(void) {
-  if (s_text_layer)   { text_layer_destroy(s_text_layer);   s_text_layer = NULL; }
-  if (s_times_layer)  { text_layer_destroy(s_times_layer);  s_times_layer = NULL; }
-  if (s_labels_layer) { layer_destroy(s_labels_layer);      s_labels_layer = NULL; }
-  if (s_date_layer)   { text_layer_destroy(s_date_layer);   s_date_layer = NULL; }
+  if (s_title_timer) { app_timer_cancel(s_title_timer); s_title_timer = NULL; }
+  prv_slide_free();
+  if (s_text_layer)    { text_layer_destroy(s_text_layer); s_text_layer = NULL; }
+  if (s_content_layer) { layer_destroy(s_content_layer);   s_content_layer = NULL; }
   s_main_window = NULL;
 }
 
 void ui_show_status(const char *text) {
-  if (s_text_layer) text_layer_set_text(s_text_layer, text ? text : "");
+  if (!s_text_layer) return;
+  if (!text) text = "";
+  // Every day shown clears the status; don't make the firmware re-lay it out each time.
+  // Only the empty case is skipped: callers reuse static buffers for the rest.
+  if (!text[0] && !text_layer_get_text(s_text_layer)[0]) return;
+  // A day that shows up after this is news, not the next step of a scroll
+  if (text[0]) s_slide.pending = 0;
+  text_layer_set_text(s_text_layer, text);
+}
+
+void ui_show_status_detail(const char *what, const char *detail) {
+  snprintf(s_status_buf, sizeof(s_status_buf), "%s: %s", what, detail);
+  ui_show_status(s_status_buf);
 }
 
 void ui_show_daytimes(const DayTimes *dt) {
@@ -249,24 +344,93 @@ void ui_show_daytimes(const DayTimes *dt) {
     ui_show_status("Fetching…");
     return;
   }
+  PROBE_START(t_show);
   ui_show_status("");
+  stats_mark_paint();
+  PROBE_HEAP();
+
+  bool dirty = !s_have_day;
+  int8_t direction = s_slide.pending;
+  s_slide.pending = 0;
+  if (s_have_day && dt->day != s_panes[s_front].day) {
+    if (direction && prv_slide_begin(direction)) dirty = true;
+    else prv_slide_stop();
+  }
+  s_have_day = true;
+
+  DayPane *pane = &s_panes[s_front];
+  if (dt->day != pane->day) {
+    pane->day = dt->day;
+    time_t noon = (time_t)dt->day * SECONDS_PER_DAY + SECONDS_PER_DAY / 2;
+    strftime(pane->date, sizeof(pane->date), "%a %b %d", gmtime(&noon));
+    dirty = true;
+  }
+
+  const int16_t *rows = dt->times.minutes;
+  for (int i = 0; i < s_rows; i++) {
+    if (rows[i] == pane->min[i]) continue;
+    pane->min[i] = rows[i];
+    char *buf = pane->time[i];
+    if (rows[i] == SOLAR_NONE) {
+      memcpy(buf, "--:--", 6);
+    } else {
+      buf[0] = '0' + rows[i] / 600;
+      buf[1] = '0' + rows[i] / 60 % 10;
+      buf[2] = ':';
+      buf[3] = '0' + rows[i] % 60 / 10;
+      buf[4] = '0' + rows[i] % 10;
+      buf[5] = 0;
+    }
+    dirty = true;
+  }
+
+  if (dirty) s_slide.in_ready = false;
+  if (dirty && s_content_layer) layer_mark_dirty(s_content_layer);
+  PROBE_STOP(PROBE_SHOW, t_show);
+}
+
+static void prv_title_timeout(void *data) {
+  s_title_timer = NULL;
+  s_title = NULL;
+  prv_content_changed();
+}
 
-  // Date
-  if (s_date_layer) text_layer_set_text(s_date_layer, dt->date[0] ? dt->date : "");
+void ui_flash_title(const char *text) {
+  s_title = text;
+  if (s_title_timer) {
+    app_timer_reschedule(s_title_timer, TITLE_FLASH_MS);
+  } else {
+    s_title_timer = app_timer_register(TITLE_FLASH_MS, prv_title_timeout, NULL);
+  }
+  prv_content_changed();
+}
 
-  // Times
-  static char s_times_buf[32];
-  snprintf(s_times_buf, sizeof(s_times_buf),
-           "%s\n%s\n%s\n%s",
-           dt->dawn[0]    ? dt->dawn    : "--:--",
-           dt->sunrise[0] ? dt->sunrise : "--:--",
-           dt->sunset[0]  ? dt->sunset  : "--:--",
-           dt->dusk[0]    ? dt->dusk    : "--:--");
-  if (s_times_layer) text_layer_set_text(s_times_layer, s_times_buf);
+void ui_set_fields(SolarFields fields) {
+  fields = solar_fields_clamp(fields);
+  s_rows = 0;
+  for (int f = 0; f < SOLAR_FIELD_COUNT; f++) {
+    if (fields & SOLAR_FIELD(f)) s_labels[s_rows++] = fields_label(f);
+  }
+  for (int p = 0; p < 2; p++) {
+    for (int i = 0; i < SOLAR_MAX_FIELDS; i++) s_panes[p].min[i] = ROW_UNSET;
+  }
+  // Rows move and change font; a slide in progress would show stale copies
+  prv_slide_stop();
+
+  bool compact = s_rows > LAYOUT_ROWS;
+  if (compact != s_compact) {
+    s_compact = compact;
+    prv_layout_layers();
+  } else if (s_content_layer) {
+    layer_mark_dirty(s_content_layer);
+  }
+}
 
-  if (s_labels_layer) layer_mark_dirty(s_labels_layer);
+void ui_set_transition(int8_t direction) {
+  s_slide.pending = direction;
 }
 
 void ui_relayout(void) {
+  prv_slide_free();
   prv_layout_layers();
 }
@@ -1,6 +1,7 @@
 #pragma once
 #include <pebble.h>
 #include "types.h"
+#include "solar.h"
 
 // Initialize/destroy all UI layers within the given window
 void ui_init(Window *window);
@@ -8,7 +9,16 @@ void ui_deinit(void);
 
 // Display helpers
 void ui_show_status(const char *text);         // status overlay
+void ui_show_status_detail(const char *what, const char *detail);   // "what: detail"
 void ui_show_daytimes(const DayTimes *dt);     // main content
+void ui_flash_title(const char *text);         // briefly replace the date line
+
+// Rows to draw: one per field, in field order. Smaller fonts past LAYOUT_ROWS.
+void ui_set_fields(SolarFields fields);
+
+// Slide the next different day in from below (direction > 0, a later day)
+// or from above (< 0) instead of swapping it in place
+void ui_set_transition(int8_t direction);
 
 // Relayout (e.g., after config changes)
 void ui_relayout(void);
@@ -0,0 +1,111 @@
+#include <pebble.h>
+#include "wire.h"
+
+#define WIRE_V1_HEADER_SIZE        8
+#define WIRE_HEADER_SIZE           10
+#define WIRE_PATCH_V2_HEADER_SIZE  12
+#define WIRE_PATCH_HEADER_SIZE     14
+
+// Dictionary header plus the BUNDLE and the int32 SEQ, EPOCH, location and zone tuples
+#define WIRE_DICT_OVERHEAD (1 + (7 + WIRE_HEADER_SIZE) + 7 * (7 + 4))
+
+// A PATCH reply has no EPOCH, but a longer header and a day offset per record
+#define WIRE_PATCH_DICT_OVERHEAD (1 + (7 + WIRE_PATCH_HEADER_SIZE) + 6 * (7 + 4))
+
+static uint16_t prv_u16(const uint8_t *p) {
+  return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static int32_t prv_i32(const uint8_t *p) {
+  return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static int16_t prv_minutes(const uint8_t *p) {
+  uint16_t v = prv_u16(p);
+  return v == WIRE_NONE || v >= 24 * 60 ? SOLAR_NONE : (int16_t)v;
+}
+
+static uint16_t prv_record_size(SolarFields fields) {
+  return solar_field_count(fields) * sizeof(uint16_t);
+}
+
+bool wire_read_header(const uint8_t *data, uint16_t length, WireHeader *out) {
+  if (!data || length < WIRE_V1_HEADER_SIZE) return false;
+  out->version = data[0];
+  out->count = data[1];
+  out->first_offset = (int16_t)prv_u16(data + 2);
+  out->base_day = prv_i32(data + 4);
+  if (out->version == 0 || out->version > WIRE_VERSION) return false;
+  if (out->version >= 3) {
+    if (length < WIRE_HEADER_SIZE) return false;
+    out->fields = prv_u16(data + 8) & SOLAR_FIELDS_ALL;
+    out->header_size = WIRE_HEADER_SIZE;
+  } else {
+    out->fields = SOLAR_FIELDS_CLASSIC;
+    out->header_size = WIRE_V1_HEADER_SIZE;
+  }
+  return length >= out->header_size + out->count * prv_record_size(out->fields);
+}
+
+// Pick the fields of `want` out of a record holding `have`
+static bool prv_read_record(const uint8_t *rec, SolarFields have, SolarFields want, SolarDay *out) {
+  if ((have & want) != want) return false;
+  uint8_t n = 0, slot = 0;
+  for (int f = 0; f < SOLAR_FIELD_COUNT && n < SOLAR_MAX_FIELDS; f++) {
+    if (!(have & SOLAR_FIELD(f))) continue;
+    if (want & SOLAR_FIELD(f)) out->minutes[n++] = prv_minutes(rec + slot * 2);
+    slot++;
+  }
+  while (n < SOLAR_MAX_FIELDS) out->minutes[n++] = SOLAR_NONE;
+  return true;
+}
+
+bool wire_read_day(const uint8_t *data, const WireHeader *hdr, uint8_t index,
+                   SolarFields want, SolarDay *out) {
+  const uint8_t *rec = data + hdr->header_size + index * prv_record_size(hdr->fields);
+  return prv_read_record(rec, hdr->fields, want, out);
+}
+
+bool wire_read_patch(const uint8_t *data, uint16_t length, WirePatch *out) {
+  if (!data || length < WIRE_PATCH_V2_HEADER_SIZE) return false;
+  if (data[0] < 2 || data[0] > WIRE_VERSION) return false;
+  out->count = data[1];
+  out->shift = (int16_t)prv_u16(data + 2);
+  out->base_day = prv_i32(data + 4);
+  out->from_epoch = prv_u16(data + 8);
+  out->to_epoch = prv_u16(data + 10);
+  if (data[0] >= 3) {
+    if (length < WIRE_PATCH_HEADER_SIZE) return false;
+    out->fields = prv_u16(data + 12) & SOLAR_FIELDS_ALL;
+    out->header_size = WIRE_PATCH_HEADER_SIZE;
+  } else {
+    out->fields = SOLAR_FIELDS_CLASSIC;
+    out->header_size = WIRE_PATCH_V2_HEADER_SIZE;
+  }
+  if (out->shift <= -24 * 60 || out->shift >= 24 * 60) return false;
+  return length >= out->header_size + out->count * (2 + prv_record_size(out->fields));
+}
+
+bool wire_read_patch_day(const uint8_t *data, const WirePatch *patch, uint8_t index,
+                         SolarFields want, int32_t *day, SolarDay *out) {
+  const uint8_t *rec = data + patch->header_size + index * (2 + prv_record_size(patch->fields));
+  *day = patch->base_day + (int16_t)prv_u16(rec);
+  return prv_read_record(rec + 2, patch->fields, want, out);
+}
+
+uint32_t wire_reply_size(uint8_t days, SolarFields fields) {
+  uint16_t record = prv_record_size(fields);
+  uint32_t bundle = WIRE_DICT_OVERHEAD + days * record;
+  uint32_t patch = WIRE_PATCH_DICT_OVERHEAD + days * (2 + record);
+  return bundle > patch ? bundle : patch;
+}
+
+uint8_t wire_days_for_inbox(uint32_t inbox_size, SolarFields fields) {
+  uint16_t record = prv_record_size(fields);
+  if (inbox_size <= WIRE_PATCH_DICT_OVERHEAD || !record) return 0;
+  // Whichever form the phone picks has to fit
+  uint32_t days = (inbox_size - WIRE_DICT_OVERHEAD) / record;
+  uint32_t patch_days = (inbox_size - WIRE_PATCH_DICT_OVERHEAD) / (2 + record);
+  if (patch_days < days) days = patch_days;
+  return days > UINT8_MAX ? UINT8_MAX : (uint8_t)days;
+}
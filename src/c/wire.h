@@ -0,0 +1,74 @@
+#pragma once
+#include <pebble.h>
+#include "solar.h"
+
+// Binary day bundle carried in the BUNDLE byte-array tuple. Little-endian.
+//
+//   0  u8   version        wire version it was written for
+//   1  u8   count          number of records that follow
+//   2  i16  first_offset   day offset of record 0, relative to base_day
+//   4  i32  base_day       phone's local "today", days since 1970-01-01
+//   8  u16  fields         SolarFields in each record (version 3 on)
+//  10  count x record      u16 minutes per field, in field order (0xFFFF = none)
+//
+// Before version 3 the header stops at 8 and every record is the four
+// classic fields (dawn, sunrise, sunset, dusk).
+//
+// Both sides advertise WIRE_VERSION (watch in REQ, phone in HELLO) and the
+// phone answers in the lower of the two; version 0 is the legacy string keys.
+// The watch names the fields it wants in each REQ (FIELDS).
+//
+// Version 2 adds cache epochs. A bundle comes with an EPOCH naming what the
+// watch now holds; the watch echoes it in each REQ, and while it matches what
+// the phone last sent, the phone answers with a PATCH tuple instead:
+//
+//   0  u8   version        wire version it was written for
+//   1  u8   count          number of records that follow
+//   2  i16  shift          minutes added to every cached event, before the records
+//   4  i32  base_day       phone's local "today"
+//   8  u16  from_epoch     epoch the patch applies to
+//  10  u16  to_epoch       epoch the watch holds once it is applied
+//  12  u16  fields         as in the bundle (version 3 on)
+//  14  count x record      i16 offset from base_day, then as in the bundle
+
+#define WIRE_VERSION      3
+#define WIRE_NONE         0xFFFF
+
+typedef struct {
+  uint8_t version;
+  uint8_t count;
+  int16_t first_offset;
+  int32_t base_day;
+  SolarFields fields;
+  uint8_t header_size;
+} WireHeader;
+
+// Validate and read the header; false if the payload is malformed or too new
+bool wire_read_header(const uint8_t *data, uint16_t length, WireHeader *out);
+
+// Read record `index` (caller has checked it against the header's count) as
+// a record of `want`. False if the bundle lacks any of those fields.
+bool wire_read_day(const uint8_t *data, const WireHeader *hdr, uint8_t index,
+                   SolarFields want, SolarDay *out);
+
+typedef struct {
+  uint8_t count;
+  int16_t shift;
+  int32_t base_day;
+  uint16_t from_epoch;
+  uint16_t to_epoch;
+  SolarFields fields;
+  uint8_t header_size;
+} WirePatch;
+
+bool wire_read_patch(const uint8_t *data, uint16_t length, WirePatch *out);
+
+// Read patch record `index` and the absolute local day it replaces
+bool wire_read_patch_day(const uint8_t *data, const WirePatch *patch, uint8_t index,
+                         SolarFields want, int32_t *day, SolarDay *out);
+
+// Inbox bytes a reply with this many days of these fields needs, bundle or patch
+uint32_t wire_reply_size(uint8_t days, SolarFields fields);
+
+// Days with these fields that fit in one inbox message next to the other tuples
+uint8_t wire_days_for_inbox(uint32_t inbox_size, SolarFields fields);
@@ -0,0 +1,173 @@
+#include <pebble.h>
+#include "year.h"
+#include "wire.h"
+#include "msg.h"
+
+#define YEAR_STALL_MS      5000   // no chunk for this long: ask again from the gap
+#define YEAR_LOCAL_BATCH   16     // days per local fill tick
+#define YEAR_LOCAL_TICK_MS 10
+
+static YearTable *s_table = NULL;
+static YearUpdateHandler s_on_update = NULL;
+
+static uint16_t s_stream = 0;         // id of the stream we accept chunks from
+static uint8_t s_chunk_days = 0;
+static bool s_need_request = false;
+static bool s_need_ack = false;
+static AppTimer *s_stall_timer = NULL;
+
+static SolarLocation s_local_loc;
+static AppTimer *s_local_timer = NULL;
+
+static void prv_cancel(AppTimer **timer) {
+  if (*timer) {
+    app_timer_cancel(*timer);
+    *timer = NULL;
+  }
+}
+
+static bool prv_complete(void) {
+  return s_table && s_table->received >= s_table->count;
+}
+
+static void prv_put(uint16_t index, int16_t rise, int16_t set) {
+  if (index >= s_table->count || year_has(index)) return;
+  s_table->rise[index] = rise;
+  s_table->set[index] = set;
+  s_table->have[index / 8] |= 1 << (index % 8);
+  s_table->received++;
+  while (s_table->contiguous < s_table->count && year_has(s_table->contiguous)) {
+    s_table->contiguous++;
+  }
+}
+
+static void prv_stall_cb(void *data) {
+  s_stall_timer = NULL;
+  if (prv_complete() || !s_chunk_days) return;
+  year_start_stream(s_chunk_days);
+}
+
+static void prv_arm_stall(void) {
+  prv_cancel(&s_stall_timer);
+  if (!prv_complete()) s_stall_timer = app_timer_register(YEAR_STALL_MS, prv_stall_cb, NULL);
+}
+
+bool year_open(int32_t first_day, uint16_t count, YearUpdateHandler on_update) {
+  if (count > YEAR_MAX_DAYS) return false;
+  year_close();
+  s_table = calloc(1, sizeof(YearTable));
+  if (!s_table) return false;
+  s_table->first_day = first_day;
+  s_table->count = count;
+  s_on_update = on_update;
+  return true;
+}
+
+void year_close(void) {
+  prv_cancel(&s_stall_timer);
+  prv_cancel(&s_local_timer);
+  s_need_request = false;
+  s_need_ack = false;
+  s_chunk_days = 0;
+  s_on_update = NULL;
+  free(s_table);
+  s_table = NULL;
+}
+
+const YearTable *year_table(void) {
+  return s_table;
+}
+
+bool year_has(uint16_t index) {
+  return s_table && index < s_table->count && (s_table->have[index / 8] & (1 << (index % 8)));
+}
+
+void year_start_stream(uint8_t chunk_days) {
+  if (!s_table || prv_complete()) return;
+  s_chunk_days = chunk_days;
+  s_stream++;                     // chunks from an older stream are dropped
+  s_need_request = true;
+  s_need_ack = false;
+  prv_arm_stall();
+  msg_kick_outbox();
+}
+
+static void prv_local_cb(void *data) {
+  s_local_timer = NULL;
+  if (!s_table) return;
+
+  uint8_t done = 0;
+  for (uint16_t i = s_table->contiguous; i < s_table->count && done < YEAR_LOCAL_BATCH; i++) {
+    if (year_has(i)) continue;
+    SolarDay sd;
+    solar_compute_day(&s_local_loc, YEAR_FIELDS, s_table->first_day + i, &sd);
+    prv_put(i, sd.minutes[0], sd.minutes[1]);
+    done++;
+  }
+  if (s_on_update) s_on_update();
+  if (!prv_complete()) s_local_timer = app_timer_register(YEAR_LOCAL_TICK_MS, prv_local_cb, NULL);
+}
+
+void year_fill_local(const SolarLocation *loc) {
+  if (!s_table || prv_complete()) return;
+  // The phone is out of the picture; don't keep asking it
+  prv_cancel(&s_stall_timer);
+  s_need_request = false;
+  s_need_ack = false;
+  s_stream++;
+
+  s_local_loc = *loc;
+  if (!s_local_timer) s_local_timer = app_timer_register(0, prv_local_cb, NULL);
+}
+
+bool year_wants_send(void) {
+  return s_table && (s_need_request || s_need_ack);
+}
+
+void year_write(DictionaryIterator *iter, int32_t today) {
+  int32_t stream = s_stream;
+  int32_t from = s_table->contiguous;
+  if (s_need_request) {
+    int32_t offset = s_table->first_day - today;
+    int32_t count = s_table->count;
+    int32_t chunk = s_chunk_days;
+    int32_t fields = YEAR_FIELDS;
+    dict_write_int(iter, MESSAGE_KEY_YEAR, &stream, sizeof(stream), true);
+    dict_write_int(iter, MESSAGE_KEY_OFFSET, &offset, sizeof(offset), true);
+    dict_write_int(iter, MESSAGE_KEY_COUNT, &count, sizeof(count), true);
+    dict_write_int(iter, MESSAGE_KEY_YEAR_CHUNK, &chunk, sizeof(chunk), true);
+    dict_write_int(iter, MESSAGE_KEY_FIELDS, &fields, sizeof(fields), true);
+  } else {
+    dict_write_int(iter, MESSAGE_KEY_YEAR_ACK, &stream, sizeof(stream), true);
+  }
+  dict_write_int(iter, MESSAGE_KEY_YEAR_FROM, &from, sizeof(from), true);
+  s_need_request = false;
+  s_need_ack = false;
+}
+
+void year_on_send_failed(void) {
+  // The stall timer will re-ask from the gap; an ack just waits for the next chunk
+  if (s_table && !prv_complete()) s_need_ack = true;
+}
+
+void year_on_chunk(const uint8_t *data, uint16_t length, uint16_t stream) {
+  if (!s_table || stream != s_stream) return;
+
+  WireHeader hdr;
+  if (!wire_read_header(data, length, &hdr)) return;
+
+  // Records go straight from the message buffer into the table
+  int32_t first = hdr.base_day + hdr.first_offset - s_table->first_day;
+  for (uint8_t i = 0; i < hdr.count; i++) {
+    int32_t index = first + i;
+    if (index < 0 || index >= s_table->count) continue;
+    SolarDay sd;
+    if (!wire_read_day(data, &hdr, i, YEAR_FIELDS, &sd)) return;
+    prv_put((uint16_t)index, sd.minutes[0], sd.minutes[1]);
+  }
+
+  s_need_ack = true;
+  prv_arm_stall();
+  if (s_on_update) s_on_update();
+  msg_kick_outbox();
+}
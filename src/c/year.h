@@ -0,0 +1,49 @@
+#pragma once
+#include <pebble.h>
+#include "solar.h"
+
+// A calendar year of sunrise/sunset for the chart, filled progressively.
+//
+// The phone streams it as a run of CHUNK messages, each a wire bundle
+// (wire.h) tagged with the stream id from YEAR. The watch acks the number
+// of days it holds from the start (YEAR_ACK + YEAR_FROM); the phone keeps
+// at most a few chunks ahead of that. A stalled or interrupted stream is
+// resumed by asking again from the first missing day.
+
+#define YEAR_MAX_DAYS 366
+
+// The chart only plots sunrise and sunset, so that is all a stream carries
+#define YEAR_FIELDS (SOLAR_FIELD(SOLAR_SUNRISE) | SOLAR_FIELD(SOLAR_SUNSET))
+
+typedef struct {
+  int32_t first_day;          // local day of 1 January
+  uint16_t count;             // days in the year
+  uint16_t received;          // days filled so far, in any order
+  uint16_t contiguous;        // days filled from the start without a gap
+  int16_t rise[YEAR_MAX_DAYS];
+  int16_t set[YEAR_MAX_DAYS];
+  uint8_t have[(YEAR_MAX_DAYS + 7) / 8];
+} YearTable;
+
+typedef void (*YearUpdateHandler)(void);
+
+// Allocate the table for a year; `on_update` runs whenever days land
+bool year_open(int32_t first_day, uint16_t count, YearUpdateHandler on_update);
+void year_close(void);
+
+const YearTable *year_table(void);
+bool year_has(uint16_t index);
+
+// Ask the phone for whatever is still missing
+void year_start_stream(uint8_t chunk_days);
+
+// Fill the missing days with the local engine, a few per timer tick
+void year_fill_local(const SolarLocation *loc);
+
+// Outbox side, driven by msg.c: whether a request or ack is owed, and writing it
+bool year_wants_send(void);
+void year_write(DictionaryIterator *iter, int32_t today);
+void year_on_send_failed(void);
+
+// Inbox side: a CHUNK tuple and the YEAR id it came with
+void year_on_chunk(const uint8_t *data, uint16_t length, uint16_t stream);
@@ -0,0 +1,50 @@
+// Replays a trace of watch requests against a spread of sites, timing reply
+// construction and sizing the payloads without sending anything. Enabled
+// with BENCH in index.js; results go to the console.
+
+var Metrics = require('./metrics');
+var CLASSIC = require('./ephemeris').CLASSIC;
+
+var SITES = [
+  { label: 'Berlin',     lat: 52.52,  lon: 13.405 },
+  { label: 'Quito',      lat: -0.18,  lon: -78.47 },
+  { label: 'Sydney',     lat: -33.87, lon: 151.21 },
+  { label: 'Reykjavik',  lat: 64.15,  lon: -21.94 },
+  { label: 'Tromso',     lat: 69.65,  lon: 18.96 },   // polar day and night
+  { label: 'Longyear',   lat: 78.22,  lon: 15.65 },
+  { label: 'McMurdo',    lat: -77.85, lon: 166.67 }
+];
+
+// Used when nothing has been recorded yet: a cold start, then a long scroll
+// forwards and back at the watch's request width
+function syntheticTrace() {
+  var trace = [{ center: 0, count: 14, proto: 1 }, { center: 0, count: 3, proto: 0 }];
+  for (var c = 7; c <= 365; c += 7) trace.push({ center: c, count: 14, proto: 1 });
+  for (c = -7; c >= -365; c -= 7) trace.push({ center: c, count: 14, proto: 1 });
+  return trace;
+}
+
+function run(trace, encodeReply) {
+  if (!trace || !trace.length) trace = syntheticTrace();
+  console.log('bench: ' + trace.length + ' requests x ' + SITES.length + ' sites');
+
+  var total = new Metrics.Stat();
+  for (var s = 0; s < SITES.length; s++) {
+    var site = SITES[s];
+    var compute = new Metrics.Stat(), bytes = new Metrics.Stat();
+    var t0 = Date.now();
+    for (var i = 0; i < trace.length; i++) {
+      var req = { center: trace[i].center, count: trace[i].count, proto: trace[i].proto,
+                  fields: trace[i].fields || CLASSIC, seq: i };
+      var t = Date.now();
+      var msg = encodeReply(site.lat, site.lon, req);
+      compute.add(Date.now() - t);
+      bytes.add(Metrics.payloadBytes(msg));
+    }
+    total.add(Date.now() - t0);
+    console.log('bench ' + site.label + ': compute ms ' + compute + ' | bytes ' + bytes);
+  }
+  console.log('bench: ms per site ' + total);
+}
+
+module.exports = { run: run, syntheticTrace: syntheticTrace };
@@ -0,0 +1,95 @@
+// Memoized per-day event minutes, keyed by rounded location and local date.
+// LRU-evicted and persisted to localStorage so repeat visits skip the maths.
+
+var Site = require('./ephemeris').Site;
+
+var STORAGE_KEY = 'helios.daycache.v2';
+var OLD_STORAGE_KEY = 'helios.daycache.v1';
+var LIMIT = 400;            // entries; ~20 KB of JSON
+var NONE = -1;
+
+function DayCache() {
+  this.entries = {};        // key -> [lastUsed, minutes per field...]
+  this.size = 0;
+  this.tick = 0;
+  this.dirty = false;
+  this.load();
+}
+
+DayCache.prototype.load = function() {
+  localStorage.removeItem(OLD_STORAGE_KEY);
+  try {
+    var raw = localStorage.getItem(STORAGE_KEY);
+    if (!raw) return;
+    var saved = JSON.parse(raw);
+    for (var k in saved) {
+      if (!saved.hasOwnProperty(k)) continue;
+      this.entries[k] = saved[k];
+      this.size++;
+      if (saved[k][0] > this.tick) this.tick = saved[k][0];
+    }
+  } catch (ex) {
+    console.log('daycache load failed: ' + ex);
+    this.entries = {};
+    this.size = 0;
+  }
+};
+
+DayCache.prototype.save = function() {
+  if (!this.dirty) return;
+  try {
+    localStorage.setItem(STORAGE_KEY, JSON.stringify(this.entries));
+    this.dirty = false;
+  } catch (ex) {
+    console.log('daycache save failed: ' + ex);
+  }
+};
+
+// Drop the least recently used tenth in one sweep rather than one per insert
+DayCache.prototype.evict = function() {
+  var keys = Object.keys(this.entries), self = this;
+  keys.sort(function(a, b) { return self.entries[a][0] - self.entries[b][0]; });
+  var drop = Math.max(1, Math.floor(LIMIT / 10));
+  for (var i = 0; i < drop && i < keys.length; i++) {
+    delete this.entries[keys[i]];
+    this.size--;
+  }
+};
+
+// Wall-clock minute of an event, in the zone offset in force at that instant
+function minuteOfDay(ms) {
+  if (isNaN(ms)) return NONE;
+  var d = new Date(ms);
+  return d.getHours() * 60 + d.getMinutes();
+}
+
+// Minutes for each of `fields` (NONE if absent) for `count` local days
+// starting `first` days after `noon` (a Date at local noon)
+DayCache.prototype.range = function(lat, lon, noon, first, count, fields) {
+  var prefix = lat.toFixed(2) + ',' + lon.toFixed(2) + ',' + fields + ',';
+  var site = null;
+  var out = [];
+  for (var i = 0; i < count; i++) {
+    var d = new Date(noon.getTime());
+    d.setDate(d.getDate() + first + i);
+    var tz = d.getTimezoneOffset();
+    var key = prefix + Math.floor((d.getTime() - tz * 60000) / 86400000) + ',' + tz;
+
+    var e = this.entries[key];
+    if (!e) {
+      site = site || new Site(lat, lon);
+      var ev = site.events(d.getTime(), fields);
+      e = [0].concat(ev.map(minuteOfDay));
+      if (this.size >= LIMIT) this.evict();
+      this.entries[key] = e;
+      this.size++;
+    }
+    e[0] = ++this.tick;
+    this.dirty = true;
+    out.push(e.slice(1));
+  }
+  return out;
+};
+
+DayCache.NONE = NONE;
+module.exports = DayCache;
@@ -0,0 +1,152 @@
+// What the watch's day cache holds, as far as the phone knows. Every bundle
+// names the result with a new epoch; while the watch echoes that epoch back,
+// a reply only has to carry what changed since (see src/c/wire.h).
+
+var STORAGE_KEY = 'helios.sync';
+var LIMIT = 64;             // days remembered; comfortably over the widest cache
+var NONE = -1;
+
+function pushU16(out, v) { out.push(v & 0xff, (v >> 8) & 0xff); }
+function pushI32(out, v) { out.push(v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, (v >>> 24) & 0xff); }
+function wireMinutes(v) { return v === NONE ? 0xFFFF : v; }
+
+function shiftMinutes(v, by) { return v === NONE ? NONE : (v + by + 2880) % 1440; }
+
+// Minutes from a to b, folded into (-720, 720]; null if they disagree on NONE
+function delta(a, b) {
+  var d = null;
+  if (a.length !== b.length) return null;
+  for (var i = 0; i < a.length; i++) {
+    if ((a[i] === NONE) !== (b[i] === NONE)) return null;
+    if (a[i] === NONE) continue;
+    var di = ((b[i] - a[i]) % 1440 + 1440) % 1440;
+    if (di > 720) di -= 1440;
+    if (d === null) d = di;
+    else if (d !== di) return null;
+  }
+  return d === null ? 0 : d;
+}
+
+function DaySync() {
+  this.epoch = 0;
+  this.fields = 0;          // what each remembered day holds
+  this.days = {};           // local day -> minutes per field
+  this.issued = 0;          // last epoch handed out, taken or not
+  this.pending = {};        // epoch -> plan waiting for the watch to take it
+  this.load();
+}
+
+DaySync.prototype.load = function() {
+  try {
+    var saved = JSON.parse(localStorage.getItem(STORAGE_KEY));
+    if (saved && typeof saved.epoch === 'number' && saved.days) {
+      this.epoch = saved.epoch;
+      this.fields = saved.fields | 0;
+      this.days = saved.days;
+    }
+  } catch (ex) {
+    console.log('sync load failed: ' + ex);
+  }
+};
+
+DaySync.prototype.save = function() {
+  localStorage.setItem(STORAGE_KEY, JSON.stringify({ epoch: this.epoch, fields: this.fields, days: this.days }));
+};
+
+function nextEpoch(epoch) {
+  return epoch >= 0xFFFF ? 1 : epoch + 1;
+}
+
+// Work out the reply for `days` (each holding `fields`, starting `first`
+// days after local day `base`) to a watch holding `watchEpoch`, in wire
+// `version`. Returns { epoch, patch } where patch is the PATCH bytes, or
+// null when a full bundle is the better answer.
+DaySync.prototype.plan = function(watchEpoch, version, fields, base, first, days) {
+  var epoch = this.issued = nextEpoch(Math.max(this.issued, this.epoch));
+  var plan = { epoch: epoch, patch: null, fields: fields, base: base, first: first, days: days, shift: 0 };
+  this.pending[epoch] = plan;
+  if (!watchEpoch || watchEpoch !== this.epoch || fields !== this.fields) return plan;
+
+  // A shift has to fit every day we know the watch holds; days we know
+  // nothing about always go as records
+  var shift = null, known = 0, changed = [], unknown = [];
+  for (var i = 0; i < days.length; i++) {
+    var old = this.days[base + first + i];
+    if (!old) {
+      unknown.push(i);
+      continue;
+    }
+    known++;
+    var d = delta(old, days[i]);
+    if (d !== 0) changed.push(i);
+    if (d === null || (shift !== null && shift !== d)) shift = false;
+    else if (shift === null) shift = d;
+  }
+  var records = changed.concat(unknown);
+  if (shift && changed.length === known && known > 1) {
+    plan.shift = shift;
+    records = unknown;
+  }
+
+  // Version 3 headers name the fields; before that they are the classic four
+  var width = days.length ? days[0].length * 2 : 0;
+  var patchHeader = version >= 3 ? 14 : 12, bundleHeader = version >= 3 ? 10 : 8;
+  if (patchHeader + records.length * (2 + width) >= bundleHeader + days.length * width) {
+    return plan;
+  }
+
+  var bytes = [version, records.length];
+  pushU16(bytes, plan.shift & 0xffff);
+  pushI32(bytes, base);
+  pushU16(bytes, this.epoch);
+  pushU16(bytes, epoch);
+  if (version >= 3) pushU16(bytes, fields);
+  records.sort(function(a, b) { return a - b; });
+  for (var r = 0; r < records.length; r++) {
+    var rec = days[records[r]];
+    pushU16(bytes, (first + records[r]) & 0xffff);
+    for (var j = 0; j < rec.length; j++) pushU16(bytes, wireMinutes(rec[j]));
+  }
+  plan.patch = bytes;
+  return plan;
+};
+
+// The watch took the reply cut for `epoch`: it now holds what the plan said
+DaySync.prototype.commit = function(epoch) {
+  var plan = this.pending[epoch];
+  if (!plan) return;
+  this.pending = {};          // anything cut before this one is stale now
+
+  var k;
+  if (!plan.patch) {
+    this.days = {};
+  } else if (plan.shift) {
+    for (k in this.days) {
+      if (!this.days.hasOwnProperty(k)) continue;
+      this.days[k] = this.days[k].map(function(v) { return shiftMinutes(v, plan.shift); });
+    }
+  }
+  for (var i = 0; i < plan.days.length; i++) {
+    this.days[plan.base + plan.first + i] = plan.days[i].slice();
+  }
+
+  // Keep the days nearest the ones just sent
+  var keys = Object.keys(this.days);
+  if (keys.length > LIMIT) {
+    var mid = plan.base + plan.first + (plan.days.length >> 1);
+    keys.sort(function(a, b) { return Math.abs(a - mid) - Math.abs(b - mid); });
+    for (var n = LIMIT; n < keys.length; n++) delete this.days[keys[n]];
+  }
+
+  this.epoch = epoch;
+  this.fields = plan.fields;
+  this.save();
+};
+
+// Epoch a reply message moves the watch to, 0 if it does not carry one
+DaySync.epochOf = function(msg) {
+  if (msg.PATCH) return msg.PATCH[10] | (msg.PATCH[11] << 8);
+  return msg.EPOCH || 0;
+};
+
+module.exports = DaySync;
@@ -0,0 +1,93 @@
+// Batch version of SunCalc.getTimes() for the events Helios can show.
+// Same model and constants as SunCalc (and src/c/solar.c); everything that
+// depends only on the observer is computed once per Site.
+
+var PI = Math.PI, sin = Math.sin, cos = Math.cos, asin = Math.asin, acos = Math.acos;
+var rad = PI / 180;
+var dayMs = 86400000, J1970 = 2440588, J2000 = 2451545, J0 = 0.0009;
+var SIN_E = sin(rad * 23.4397);
+
+// Field numbers, in the order the events happen; keep in sync with SolarField in src/c/solar.h
+var FIELD = {
+  ASTRO_DAWN: 0, NAUTICAL_DAWN: 1, DAWN: 2, BLUE_END: 3, SUNRISE: 4, GOLDEN_END: 5,
+  NOON: 6,
+  GOLDEN_START: 7, SUNSET: 8, BLUE_START: 9, DUSK: 10, NAUTICAL_DUSK: 11, ASTRO_DUSK: 12
+};
+var FIELD_COUNT = 13;
+var MAX_FIELDS = 5;         // SOLAR_MAX_FIELDS
+var CLASSIC = (1 << FIELD.DAWN) | (1 << FIELD.SUNRISE) | (1 << FIELD.SUNSET) | (1 << FIELD.DUSK);
+
+// Rise/set pairs by altitude
+var PAIRS = [
+  [sin(-18 * rad), FIELD.ASTRO_DAWN, FIELD.ASTRO_DUSK],
+  [sin(-12 * rad), FIELD.NAUTICAL_DAWN, FIELD.NAUTICAL_DUSK],
+  [sin(-6 * rad), FIELD.DAWN, FIELD.DUSK],
+  [sin(-4 * rad), FIELD.BLUE_END, FIELD.BLUE_START],
+  [sin(-0.833 * rad), FIELD.SUNRISE, FIELD.SUNSET],
+  [sin(6 * rad), FIELD.GOLDEN_END, FIELD.GOLDEN_START]
+];
+
+// The first MAX_FIELDS fields of a mask, as the watch would keep them
+function clampFields(fields) {
+  var out = 0, n = 0;
+  for (var f = 0; f < FIELD_COUNT && n < MAX_FIELDS; f++) {
+    if (fields & (1 << f)) {
+      out |= 1 << f;
+      n++;
+    }
+  }
+  return out;
+}
+
+function Site(lat, lon) {
+  this.lw = rad * -lon;
+  this.lwTurns = this.lw / (2 * PI);
+  var phi = rad * lat;
+  this.sinPhi = sin(phi);
+  this.cosPhi = cos(phi);
+}
+
+// Hour angle (fraction of a day) at which the sun reaches sin(h), NaN if never
+Site.prototype.hourAngle = function(sinH, sinDec, cosDec) {
+  return acos((sinH - this.sinPhi * sinDec) / (this.cosPhi * cosDec)) / (2 * PI);
+};
+
+// Times of the events in `fields` (a mask of FIELD bits, default the classic
+// four), in field order, as ms since the epoch (NaN if absent), for the
+// solar day whose transit is nearest `ms`
+Site.prototype.events = function(ms, fields) {
+  if (fields === undefined) fields = CLASSIC;
+  var d = ms / dayMs - 0.5 + J1970 - J2000;
+  var n = Math.round(d - J0 - this.lwTurns);
+  var ds = J0 + this.lwTurns + n;
+  var M = rad * (357.5291 + 0.98560028 * ds);
+  var L = M + rad * (1.9148 * sin(M) + 0.02 * sin(2 * M) + 0.0003 * sin(3 * M)) + rad * 102.9372 + PI;
+  var sinDec = SIN_E * sin(L);
+  var cosDec = cos(asin(sinDec));
+  var noon = J2000 + ds + 0.0053 * sin(M) - 0.0069 * sin(2 * L);
+
+  function toMs(j) { return (j + 0.5 - J1970) * dayMs; }
+
+  var all = [];
+  all[FIELD.NOON] = toMs(noon);
+  for (var i = 0; i < PAIRS.length; i++) {
+    var p = PAIRS[i];
+    if (!(fields & ((1 << p[1]) | (1 << p[2])))) continue;
+    var w = this.hourAngle(p[0], sinDec, cosDec);
+    all[p[1]] = toMs(noon - w);
+    all[p[2]] = toMs(noon + w);
+  }
+  var out = [];
+  for (var f = 0; f < FIELD_COUNT; f++) {
+    if (fields & (1 << f)) out.push(all[f]);
+  }
+  return out;
+};
+
+module.exports = {
+  Site: Site,
+  FIELD: FIELD,
+  FIELD_COUNT: FIELD_COUNT,
+  CLASSIC: CLASSIC,
+  clampFields: clampFields
+};
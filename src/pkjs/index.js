@@ -1,4 +1,18 @@
 var SunCalc = require('suncalc');
+var DayCache = require('./daycache');
+var ephemeris = require('./ephemeris');
+var Site = ephemeris.Site;
+var Metrics = require('./metrics');
+var Places = require('./places');
+var Settings = require('./settings');
+var DaySync = require('./daysync');
+
+var dayCache = new DayCache();
+var metrics = new Metrics();
+var sync = new DaySync();
+
+// Set to replay recorded watch requests against a spread of sites on start-up
+var BENCH = false;
 
 function two(n) { return n < 10 ? '0' + n : '' + n; }
 function fmtHM(d) { return two(d.getHours()) + ':' + two(d.getMinutes()); }
@@ -8,93 +22,395 @@ function fmtDate(d) {
   return days[d.getDay()] + ' ' + months[d.getMonth()] + ' ' + two(d.getDate());
 }
 
-var DEFAULT = { lat: 52.5200, lon: 13.4050, label: 'Berlin' };
+var FALLBACK = { lat: 52.5200, lon: 13.4050, label: 'Berlin' };
+
+// Without a fix, the first saved place beats a city on the other side of the world
+function defaultSite() {
+  var first = Places.load()[0];
+  return first ? { lat: first.lat, lon: first.lon, label: first.name } : FALLBACK;
+}
+var DEFAULT = defaultSite();
+
+// Binary bundle layout; keep in sync with src/c/wire.h. Version 2 adds
+// epochs and patches, version 3 lets the watch pick the fields.
+var WIRE_VERSION = 3;
+var WIRE_NONE = 0xFFFF;
+
+function localDay(d) {
+  return Math.floor((d.getTime() - d.getTimezoneOffset() * 60000) / 86400000);
+}
+// The phone's next UTC offset change within a year as [UTC seconds, offset in
+// seconds], or [0, current offset] when the zone holds; the watch switches
+// saved places over at that instant. Memoized for the hour.
+var zoneMemo = { hour: -1, change: null };
+function nextZoneChange(now) {
+  var hour = Math.floor(now / 3600000);
+  if (zoneMemo.hour === hour) return zoneMemo.change;
+  var tz = new Date(now).getTimezoneOffset();
+  var change = [0, -tz * 60];
+  for (var day = 1; day <= 366; day++) {
+    var hi = now + day * 86400000;
+    if (new Date(hi).getTimezoneOffset() === tz) continue;
+    var lo = hi - 86400000;
+    while (hi - lo > 60000) {
+      var mid = lo + Math.floor((hi - lo) / 2);
+      if (new Date(mid).getTimezoneOffset() === tz) lo = mid; else hi = mid;
+    }
+    hi = Math.floor(hi / 60000) * 60000;
+    change = [Math.floor(hi / 1000), -new Date(hi).getTimezoneOffset() * 60];
+    break;
+  }
+  zoneMemo = { hour: hour, change: change };
+  return change;
+}
+
+function pushU16(out, v) { out.push(v & 0xff, (v >> 8) & 0xff); }
+function pushI32(out, v) { out.push(v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, (v >>> 24) & 0xff); }
+
+// Polar days have no rise/set; SunCalc hands back Invalid Dates for those
+function fmtEvent(d) { return isNaN(d.getTime()) ? '--:--' : fmtHM(d); }
 
 function timesFor(date, lat, lon) {
   var t = SunCalc.getTimes(date, lat, lon);
   return {
     DATE: fmtDate(date),
-    DAWN: fmtHM(t.dawn),
-    SUNRISE: fmtHM(t.sunrise),
-    SUNSET: fmtHM(t.sunset),
-    DUSK: fmtHM(t.dusk)
+    DAWN: fmtEvent(t.dawn),
+    SUNRISE: fmtEvent(t.sunrise),
+    SUNSET: fmtEvent(t.sunset),
+    DUSK: fmtEvent(t.dusk)
   };
 }
 
-function sendBundle(lat, lon, centerOffset) {
+// Message builders are kept free of I/O so the bench can time them
+
+function encodeLegacy(lat, lon, centerOffset, seq) {
+  // Local noon, so the solar cycle matches what the watch computes on its own
+  var d0 = new Date();
+  d0.setHours(12, 0, 0, 0);
+  var dm1 = new Date(d0.getTime());
+  var dC  = new Date(d0.getTime());
+  var dp1 = new Date(d0.getTime());
+
+  dm1.setDate(dm1.getDate() + (centerOffset - 1));
+  dC.setDate(dC.getDate() + centerOffset);
+  dp1.setDate(dp1.getDate() + (centerOffset + 1));
+
+  var m1 = timesFor(dm1, lat, lon);
+  var c0 = timesFor(dC,  lat, lon);
+  var p1 = timesFor(dp1, lat, lon);
+
+  return {
+    SEQ: seq,
+    CENTER: centerOffset,
+    LAT: Math.round(lat * 1e6),
+    LON: Math.round(lon * 1e6),
+    UTC_OFFSET: -d0.getTimezoneOffset() * 60,
+
+    DATE_M1: m1.DATE, DAWN_M1: m1.DAWN, SUNRISE_M1: m1.SUNRISE, SUNSET_M1: m1.SUNSET, DUSK_M1: m1.DUSK,
+    DATE_0:  c0.DATE, DAWN_0:  c0.DAWN, SUNRISE_0:  c0.SUNRISE, SUNSET_0:  c0.SUNSET, DUSK_0:  c0.DUSK,
+    DATE_P1: p1.DATE, DAWN_P1: p1.DAWN, SUNRISE_P1: p1.SUNRISE, SUNSET_P1: p1.SUNSET, DUSK_P1: p1.DUSK
+  };
+}
+
+// Before version 3 a bundle is the classic four fields and says version 1
+function bundleBytes(version, fields, base, first, days) {
+  var bytes = [version >= 3 ? 3 : 1, days.length];
+  pushU16(bytes, first & 0xffff);
+  pushI32(bytes, base);
+  if (version >= 3) pushU16(bytes, fields);
+  for (var i = 0; i < days.length; i++) {
+    for (var j = 0; j < days[i].length; j++) {
+      pushU16(bytes, days[i][j] === DayCache.NONE ? WIRE_NONE : days[i][j]);
+    }
+  }
+  return bytes;
+}
+
+// Wire bundle for `count` days starting `first` days from today; a watch that
+// names its fields gets a version 3 bundle of just those
+function encodeDays(lat, lon, first, count, fields) {
+  var d0 = new Date();
+  d0.setHours(12, 0, 0, 0);
+  var version = fields ? 3 : 1;
+  fields = fields || ephemeris.CLASSIC;
+  var days = dayCache.range(lat, lon, d0, first, count, fields);
+  dayCache.save();
+  return bundleBytes(version, fields, localDay(d0), first, days);
+}
+
+// A bundle, or with protocol 2 a patch against the epoch the watch holds
+function encodeBinary(lat, lon, req) {
+  var d0 = new Date();
+  d0.setHours(12, 0, 0, 0);
+  var version = Math.min(req.proto, WIRE_VERSION);
+  var fields = version >= 3 ? req.fields : ephemeris.CLASSIC;
+  var first = req.center - (req.count >> 1);
+  var days = dayCache.range(lat, lon, d0, first, req.count, fields);
+  dayCache.save();
+
+  var msg = {
+    SEQ: req.seq,
+    LAT: Math.round(lat * 1e6),
+    LON: Math.round(lon * 1e6),
+    UTC_OFFSET: -d0.getTimezoneOffset() * 60
+  };
+  var zone = nextZoneChange(Date.now());
+  msg.UTC_CHANGE = zone[0];
+  msg.UTC_OFFSET_NEXT = zone[1];
+  if (version < 2) {
+    msg.BUNDLE = bundleBytes(version, fields, localDay(d0), first, days);
+    return msg;
+  }
+  var plan = sync.plan(req.epoch, version, fields, localDay(d0), first, days);
+  if (plan.patch) {
+    msg.PATCH = plan.patch;
+  } else {
+    msg.BUNDLE = bundleBytes(version, fields, localDay(d0), first, days);
+    msg.EPOCH = plan.epoch;
+  }
+  return msg;
+}
+
+// Answer in the highest protocol both sides speak
+function encodeReply(lat, lon, req) {
+  if (Math.min(req.proto, WIRE_VERSION) >= 1) {
+    return encodeBinary(lat, lon, req);
+  }
+  return encodeLegacy(lat, lon, req.center, req.seq);
+}
+
+function reply(lat, lon, req) {
+  var sample = metrics.begin(req);
+  var msg;
   try {
-    var d0 = new Date();
-    var dm1 = new Date(d0.getTime());
-    var dC  = new Date(d0.getTime());
-    var dp1 = new Date(d0.getTime());
-
-    dm1.setDate(dm1.getDate() + (centerOffset - 1));
-    dC.setDate(dC.getDate() + centerOffset);
-    dp1.setDate(dp1.getDate() + (centerOffset + 1));
-
-    var m1 = timesFor(dm1, lat, lon);
-    var c0 = timesFor(dC,  lat, lon);
-    var p1 = timesFor(dp1, lat, lon);
-
-    Pebble.sendAppMessage({
-      CENTER: centerOffset,
-
-      DATE_M1: m1.DATE, DAWN_M1: m1.DAWN, SUNRISE_M1: m1.SUNRISE, SUNSET_M1: m1.SUNSET, DUSK_M1: m1.DUSK,
-      DATE_0:  c0.DATE, DAWN_0:  c0.DAWN, SUNRISE_0:  c0.SUNRISE, SUNSET_0:  c0.SUNSET, DUSK_0:  c0.DUSK,
-      DATE_P1: p1.DATE, DAWN_P1: p1.DAWN, SUNRISE_P1: p1.SUNRISE, SUNSET_P1: p1.SUNSET, DUSK_P1: p1.DUSK
-    }, function(){}, function(e){
-      console.log('send failed: ' + JSON.stringify(e));
-    });
+    msg = encodeReply(lat, lon, req);
   } catch (ex) {
     console.log('SunCalc error: ' + ex);
-    Pebble.sendAppMessage({ ERROR: 'Calc error' });
+    Pebble.sendAppMessage({ ERROR: 'Calc error', SEQ: req.seq });
+    return;
   }
+  metrics.encoded(sample, msg);
+  lastSent = { lat: lat, lon: lon };
+  var epoch = DaySync.epochOf(msg);
+  Pebble.sendAppMessage(msg, function() {
+    metrics.sent(sample);
+    if (epoch) {
+      // Later pushes for this request are cut against what the watch now holds
+      sync.commit(epoch);
+      req.epoch = epoch;
+    }
+  }, function(e) {
+    console.log('send failed: ' + JSON.stringify(e));
+  });
 }
 
-function updateFromLocation(centerOffset) {
-  var usedFallback = false;
+// Year stream: the watch asks for COUNT days from OFFSET in chunks of
+// YEAR_CHUNK, resuming at YEAR_FROM. One message is on the air at a time and
+// at most YEAR_WINDOW chunks run ahead of what the watch has acked.
+var YEAR_WINDOW = 3;
+var YEAR_RETRY_MS = 500;
+var YEAR_MAX_RETRIES = 5;
 
-  var fallbackTimer = setTimeout(function() {
-    usedFallback = true;
-    console.log('Geolocation timeout; using default ' + DEFAULT.label);
-    sendBundle(DEFAULT.lat, DEFAULT.lon, centerOffset);
-  }, 7000);
+var stream = null;
+
+function sendSettings() {
+  Pebble.sendAppMessage(Settings.message(), null, function(e) {
+    console.log('settings send failed: ' + JSON.stringify(e));
+  });
+}
+
+function startYear(p) {
+  var fix = lastFix || DEFAULT;
+  stream = {
+    id: p.YEAR | 0,
+    lat: fix.lat,
+    lon: fix.lon,
+    offset: p.OFFSET | 0,
+    count: Math.max(0, Math.min(p.COUNT | 0, 366)),
+    chunk: Math.max(1, Math.min((p.YEAR_CHUNK | 0) || 7, 255)),
+    fields: ephemeris.clampFields(p.FIELDS | 0),
+    next: p.YEAR_FROM | 0,
+    acked: p.YEAR_FROM | 0,
+    busy: false,
+    retries: 0
+  };
+  pumpYear();
+}
+
+function ackYear(p) {
+  if (!stream || (p.YEAR_ACK | 0) !== stream.id) return;
+  var from = p.YEAR_FROM | 0;
+  if (from > stream.acked) stream.acked = from;
+  pumpYear();
+}
+
+function pumpYear() {
+  var s = stream;
+  if (!s || s.busy || s.next >= s.count) return;
+  if (s.next - s.acked >= YEAR_WINDOW * s.chunk) return;   // wait for the watch
+
+  var n = Math.min(s.chunk, s.count - s.next);
+  var msg = { YEAR: s.id, CHUNK: encodeDays(s.lat, s.lon, s.offset + s.next, n, s.fields) };
+  s.busy = true;
+  Pebble.sendAppMessage(msg, function() {
+    s.busy = false;
+    s.retries = 0;
+    s.next += n;
+    if (stream === s) pumpYear();
+  }, function(e) {
+    s.busy = false;
+    if (stream !== s) return;
+    // Past a few tries the watch will notice the stall and resume the stream
+    if (++s.retries > YEAR_MAX_RETRIES) {
+      console.log('year stream stalled: ' + JSON.stringify(e));
+      return;
+    }
+    setTimeout(function() { if (stream === s) pumpYear(); }, YEAR_RETRY_MS * s.retries);
+  });
+}
+
+// Location: answer from the last good fix right away and refresh it in the
+// background with a coarse (network) fix. The watch only hears about the new
+// position if it moves one of today's events by a minute or more.
+var FIX_KEY = 'helios.fix';
+var FIX_FRESH_MS = 10 * 60 * 1000;     // younger fixes are used as they are
+var FIRST_FIX_TIMEOUT_MS = 7000;
+
+var lastFix = loadFix();               // { lat, lon, ts }
+var lastReq = null;                    // most recent watch request, for pushes
+var lastSent = null;                   // { lat, lon } the watch last heard
+var refreshing = false;
+var waiters = [];                      // onDone callbacks for the refresh in flight
+
+function loadFix() {
+  try {
+    var fix = JSON.parse(localStorage.getItem(FIX_KEY));
+    return fix && typeof fix.lat === 'number' && typeof fix.lon === 'number' ? fix : null;
+  } catch (ex) {
+    return null;
+  }
+}
 
+function storeFix(lat, lon) {
+  lastFix = { lat: lat, lon: lon, ts: Date.now() };
+  localStorage.setItem(FIX_KEY, JSON.stringify(lastFix));
+}
+
+// Would moving from a to b change any of today's events by a whole minute?
+function movesMinutes(a, b) {
+  var noon = new Date();
+  noon.setHours(12, 0, 0, 0);
+  var ea = new Site(a.lat, a.lon).events(noon.getTime());
+  var eb = new Site(b.lat, b.lon).events(noon.getTime());
+  for (var i = 0; i < ea.length; i++) {
+    if (isNaN(ea[i]) !== isNaN(eb[i])) return true;
+    if (isNaN(ea[i])) continue;        // absent at both
+    if (Math.floor(ea[i] / 60000) !== Math.floor(eb[i] / 60000)) return true;
+  }
+  return false;
+}
+
+// Callers that ask while a refresh is in flight wait for that one
+function refreshLocation(onDone) {
+  if (onDone) waiters.push(onDone);
+  if (refreshing) return;
   if (!navigator.geolocation || !navigator.geolocation.getCurrentPosition) {
-    clearTimeout(fallbackTimer);
-    usedFallback = true;
-    console.log('Geolocation API missing; using default ' + DEFAULT.label);
-    sendBundle(DEFAULT.lat, DEFAULT.lon, centerOffset);
+    console.log('Geolocation API missing');
+    resolveRefresh(false);
     return;
   }
-
+  refreshing = true;
   navigator.geolocation.getCurrentPosition(function(pos) {
-    if (usedFallback) return;
-    clearTimeout(fallbackTimer);
-    sendBundle(pos.coords.latitude, pos.coords.longitude, centerOffset);
+    storeFix(pos.coords.latitude, pos.coords.longitude);
+    resolveRefresh(true);
   }, function(err) {
-    if (usedFallback) return;
-    clearTimeout(fallbackTimer);
     console.log('Geolocation error: ' + JSON.stringify(err));
-    sendBundle(DEFAULT.lat, DEFAULT.lon, centerOffset);
+    resolveRefresh(false);
   }, {
-    enableHighAccuracy: true,
-    maximumAge: 15 * 60 * 1000,
-    timeout: 6000
+    enableHighAccuracy: false,
+    maximumAge: 30 * 60 * 1000,
+    timeout: 30000
+  });
+}
+
+function resolveRefresh(ok) {
+  refreshing = false;
+  var done = waiters;
+  waiters = [];
+  for (var i = 0; i < done.length; i++) done[i](ok);
+  if (ok && lastReq && lastSent && movesMinutes(lastSent, lastFix)) {
+    console.log('Location moved; pushing update');
+    reply(lastFix.lat, lastFix.lon, lastReq);
+  }
+}
+
+function updateFromLocation(req) {
+  lastReq = req;
+
+  if (lastFix) {
+    reply(lastFix.lat, lastFix.lon, req);
+    if (Date.now() - lastFix.ts > FIX_FRESH_MS) refreshLocation(null);
+    return;
+  }
+
+  // Nothing to go on yet: wait for a first fix, but not forever
+  var answered = false;
+  var fallbackTimer = setTimeout(function() {
+    answered = true;
+    console.log('Geolocation timeout; using default ' + DEFAULT.label);
+    reply(DEFAULT.lat, DEFAULT.lon, req);
+  }, FIRST_FIX_TIMEOUT_MS);
+
+  refreshLocation(function(ok) {
+    // A late first fix corrects the default through resolveRefresh()
+    if (answered) return;
+    answered = true;
+    clearTimeout(fallbackTimer);
+    if (ok) {
+      reply(lastFix.lat, lastFix.lon, req);
+    } else {
+      console.log('No location; using default ' + DEFAULT.label);
+      reply(DEFAULT.lat, DEFAULT.lon, req);
+    }
   });
 }
 
 Pebble.addEventListener('ready', function() {
   console.log('PKJS ready');
-  Pebble.sendAppMessage({ HELLO: 1 });
+  if (BENCH) {
+    require('./bench').run(metrics.trace(), encodeReply);
+  }
+  Pebble.sendAppMessage({ HELLO: 1, PROTO: WIRE_VERSION }, sendSettings);
+  if (!lastFix || Date.now() - lastFix.ts > FIX_FRESH_MS) refreshLocation(null);
 });
 
 Pebble.addEventListener('appmessage', function(e) {
-  var center = 0;
-  if (e && e.payload && typeof e.payload.OFFSET === 'number') {
-    center = e.payload.OFFSET|0;
+  var p = (e && e.payload) || {};
+  var req = {
+    center: typeof p.OFFSET === 'number' ? p.OFFSET|0 : 0,
+    proto: typeof p.PROTO === 'number' ? p.PROTO|0 : 0,
+    count: typeof p.COUNT === 'number' ? Math.max(1, Math.min(p.COUNT|0, 255)) : 3,
+    seq: typeof p.SEQ === 'number' ? p.SEQ|0 : 0,  // echoed so the watch can spot stale replies
+    epoch: typeof p.EPOCH === 'number' ? p.EPOCH & 0xffff : 0,
+    fields: ephemeris.clampFields(p.FIELDS | 0) || ephemeris.CLASSIC
+  };
+  if (p.YEAR) {
+    startYear(p);
+  } else if (p.YEAR_ACK) {
+    ackYear(p);
   }
-  if (e && e.payload && e.payload.REQ) {
-    updateFromLocation(center);
+  if (p.REQ) {
+    metrics.record(req);
+    updateFromLocation(req);
   }
 });
+
+Pebble.addEventListener('showConfiguration', function() {
+  Pebble.openURL(Settings.configUrl());
+});
+
+Pebble.addEventListener('webviewclosed', function(e) {
+  if (!Settings.applyResponse(e && e.response)) return;
+  DEFAULT = defaultSite();
+  sendSettings();
+});
@@ -0,0 +1,99 @@
+// Per-reply timings and payload sizes, plus a short trace of watch requests
+// that bench.js can replay. Summaries go to the console every so often.
+
+var TRACE_KEY = 'helios.trace';
+var TRACE_LIMIT = 64;       // requests kept for replay
+var REPORT_EVERY = 25;      // replies between summaries
+
+// AppMessage dictionary size: 1 byte count, then 7 bytes header per tuple
+function payloadBytes(msg) {
+  var n = 1;
+  for (var k in msg) {
+    if (!msg.hasOwnProperty(k)) continue;
+    var v = msg[k];
+    if (typeof v === 'number') n += 7 + 4;
+    else if (typeof v === 'string') n += 7 + unescape(encodeURIComponent(v)).length + 1;
+    else if (v && typeof v.length === 'number') n += 7 + v.length;
+  }
+  return n;
+}
+
+function Stat() {
+  this.n = 0;
+  this.sum = 0;
+  this.max = 0;
+}
+
+Stat.prototype.add = function(v) {
+  this.n++;
+  this.sum += v;
+  if (v > this.max) this.max = v;
+};
+
+Stat.prototype.toString = function() {
+  return this.n ? (this.sum / this.n).toFixed(1) + ' avg, ' + this.max + ' max' : '-';
+};
+
+function Metrics() {
+  this.compute = new Stat();    // ms spent building a reply
+  this.bytes = new Stat();      // dictionary bytes per reply
+  this.toSend = new Stat();     // ms from the watch asking to the send being acked
+  this.requests = [];           // { at, center, count, proto } since start-up
+  this.started = Date.now();
+}
+
+// Note a watch request as it arrives
+Metrics.prototype.record = function(req) {
+  req.received = Date.now();
+  this.requests.push({
+    at: req.received - this.started,
+    center: req.center,
+    count: req.count,
+    proto: req.proto,
+    fields: req.fields
+  });
+  if (this.requests.length > TRACE_LIMIT) this.requests.shift();
+  try {
+    localStorage.setItem(TRACE_KEY, JSON.stringify(this.requests));
+  } catch (ex) {
+    // The trace is a nicety; never let it get in the way of a reply
+  }
+};
+
+// Recorded requests, from this session or, failing that, the last one
+Metrics.prototype.trace = function() {
+  if (this.requests.length) return this.requests.slice();
+  try {
+    return JSON.parse(localStorage.getItem(TRACE_KEY)) || [];
+  } catch (ex) {
+    return [];
+  }
+};
+
+Metrics.prototype.begin = function(req) {
+  // Pushes reuse an old request; time those from when they were started
+  var sample = { t0: Date.now(), since: req.received || Date.now() };
+  req.received = 0;
+  return sample;
+};
+
+Metrics.prototype.encoded = function(sample, msg) {
+  this.compute.add(Date.now() - sample.t0);
+  this.bytes.add(payloadBytes(msg));
+};
+
+Metrics.prototype.sent = function(sample) {
+  this.toSend.add(Date.now() - sample.since);
+  if (this.toSend.n % REPORT_EVERY === 0) this.report();
+};
+
+Metrics.prototype.report = function() {
+  console.log('replies: ' + this.bytes.n +
+              ' | compute ms ' + this.compute +
+              ' | bytes ' + this.bytes +
+              ' | to send ms ' + this.toSend);
+};
+
+Metrics.payloadBytes = payloadBytes;
+Metrics.Stat = Stat;
+module.exports = Metrics;
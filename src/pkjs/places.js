@@ -0,0 +1,66 @@
+// Saved places: kept in localStorage, edited on the config page (settings.js)
+// and sent to the watch as one packed PLACES message (layout in src/c/places.h).
+
+var PLACES_KEY = 'helios.places';
+var PLACES_VERSION = 1;
+var PLACES_MAX = 5;          // the watch adds "Here" in front
+var NAME_MAX = 15;           // PLACE_NAME_LEN less the terminator
+
+function pushI32(out, v) { out.push(v & 0xff, (v >> 8) & 0xff, (v >> 16) & 0xff, (v >>> 24) & 0xff); }
+
+// Keep only well-formed entries, trimmed to what the watch can hold
+function clean(list) {
+  var out = [];
+  for (var i = 0; list && i < list.length && out.length < PLACES_MAX; i++) {
+    var p = list[i];
+    var lat = parseFloat(p && p.lat);
+    var lon = parseFloat(p && p.lon);
+    var name = String((p && p.name) || '').trim().substring(0, NAME_MAX);
+    if (!name || isNaN(lat) || isNaN(lon) || Math.abs(lat) > 90 || Math.abs(lon) > 180) continue;
+    out.push({ name: name, lat: lat, lon: lon });
+  }
+  return out;
+}
+
+function load() {
+  try {
+    return clean(JSON.parse(localStorage.getItem(PLACES_KEY)));
+  } catch (ex) {
+    return [];
+  }
+}
+
+function save(list) {
+  localStorage.setItem(PLACES_KEY, JSON.stringify(clean(list)));
+}
+
+// ASCII only; the watch fonts have little beyond it anyway
+function nameBytes(name) {
+  var out = [];
+  for (var i = 0; i < name.length && out.length < NAME_MAX; i++) {
+    var c = name.charCodeAt(i);
+    out.push(c < 0x20 || c > 0x7e ? 0x3f : c);
+  }
+  return out;
+}
+
+function encode(list) {
+  var bytes = [PLACES_VERSION, list.length];
+  for (var i = 0; i < list.length; i++) {
+    var name = nameBytes(list[i].name);
+    bytes.push(name.length);
+    bytes.push.apply(bytes, name);
+    pushI32(bytes, Math.round(list[i].lat * 1e6));
+    pushI32(bytes, Math.round(list[i].lon * 1e6));
+  }
+  return bytes;
+}
+
+module.exports = {
+  load: load,
+  save: save,
+  clean: clean,
+  encode: encode,
+  MAX: PLACES_MAX,
+  NAME_MAX: NAME_MAX
+};
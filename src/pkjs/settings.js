@@ -0,0 +1,95 @@
+// Config page: saved places, which events the watch shows, and whether the
+// background worker may run. All go to the watch in one message (PLACES,
+// FIELDS and WORKER) after the page closes.
+
+var Places = require('./places');
+var ephemeris = require('./ephemeris');
+
+var FIELDS_KEY = 'helios.fields';
+var WORKER_KEY = 'helios.worker';
+
+// Config page order and wording, in field order
+var FIELD_NAMES = [
+  'Astronomical dawn', 'Nautical dawn', 'Civil dawn', 'Blue hour ends', 'Sunrise',
+  'Golden hour ends', 'Solar noon',
+  'Golden hour', 'Sunset', 'Blue hour', 'Civil dusk', 'Nautical dusk', 'Astronomical dusk'
+];
+
+function loadFields() {
+  var fields = ephemeris.clampFields(parseInt(localStorage.getItem(FIELDS_KEY), 10) || 0);
+  return fields || ephemeris.CLASSIC;
+}
+
+function saveFields(fields) {
+  localStorage.setItem(FIELDS_KEY, String(ephemeris.clampFields(fields) || ephemeris.CLASSIC));
+}
+
+// Off unless asked for: the watch has a single background slot, and taking
+// it would prompt to replace the user's sleep or step tracker
+function loadWorker() {
+  return localStorage.getItem(WORKER_KEY) === '1';
+}
+
+// What the watch needs to match the phone's settings
+function message() {
+  return { PLACES: Places.encode(Places.load()), FIELDS: loadFields(), WORKER: loadWorker() ? 1 : 0 };
+}
+
+function escape(s) {
+  return String(s).replace(/&/g, '&amp;').replace(/"/g, '&quot;').replace(/</g, '&lt;');
+}
+
+// Self-contained page; returns { places, fields } as JSON
+function configUrl() {
+  var list = Places.load(), fields = loadFields(), worker = loadWorker();
+  var rows = '';
+  for (var i = 0; i < Places.MAX; i++) {
+    var p = list[i] || { name: '', lat: '', lon: '' };
+    rows += '<p><input name="n" maxlength="' + Places.NAME_MAX + '" placeholder="Name" value="' +
+            escape(p.name) + '">' +
+            '<input name="a" placeholder="Lat" value="' + p.lat + '">' +
+            '<input name="o" placeholder="Lon" value="' + p.lon + '"></p>';
+  }
+  var boxes = '';
+  for (var f = 0; f < FIELD_NAMES.length; f++) {
+    boxes += '<label><input type="checkbox" name="f" value="' + f + '"' +
+             (fields & (1 << f) ? ' checked' : '') + '> ' + FIELD_NAMES[f] + '</label><br>';
+  }
+  var html = '<!DOCTYPE html><html><head><meta name="viewport" content="width=device-width">' +
+    '<style>body{font-family:sans-serif}p input{width:30%;margin-right:2%}</style></head><body>' +
+    '<form id="f"><h3>Events</h3><p>Up to 5; the first ones in the day win.</p>' + boxes +
+    '<h3>Saved places</h3>' + rows +
+    '<h3>Background</h3><label><input type="checkbox" id="w"' + (worker ? ' checked' : '') +
+    '> Keep the coming week ready between launches</label>' +
+    '<p>Uses the watch\'s only background app slot.</p>' +
+    '<button type="submit">Save</button></form>' +
+    '<script>document.getElementById("f").onsubmit=function(e){e.preventDefault();' +
+    'var n=document.getElementsByName("n"),a=document.getElementsByName("a"),o=document.getElementsByName("o"),l=[];' +
+    'for(var i=0;i<n.length;i++)if(n[i].value)l.push({name:n[i].value,lat:a[i].value,lon:o[i].value});' +
+    'var c=document.getElementsByName("f"),m=0;for(i=0;i<c.length;i++)if(c[i].checked)m|=1<<c[i].value;' +
+    'document.location="pebblejs://close#"+encodeURIComponent(JSON.stringify({places:l,fields:m,worker:document.getElementById("w").checked}));};' +
+    '</script></body></html>';
+  return 'data:text/html;charset=utf-8,' + encodeURIComponent(html);
+}
+
+// Save what the page sent back; false if it was dismissed
+function applyResponse(response) {
+  if (!response || response === 'CANCELLED') return false;
+  try {
+    var r = JSON.parse(decodeURIComponent(response));
+    Places.save(r.places || []);
+    saveFields(r.fields | 0);
+    localStorage.setItem(WORKER_KEY, r.worker ? '1' : '0');
+    return true;
+  } catch (ex) {
+    console.log('bad settings response: ' + ex);
+    return false;
+  }
+}
+
+module.exports = {
+  loadFields: loadFields,
+  message: message,
+  configUrl: configUrl,
+  applyResponse: applyResponse
+};
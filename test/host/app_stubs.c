@@ -0,0 +1,47 @@
+#include <pebble.h>
+#include "year.h"
+#include "refresh.h"
+#include "glance.h"
+
+// Modules msg.c calls into that the scripted runs do not exercise
+
+bool year_open(int32_t first_day, uint16_t count, YearUpdateHandler on_update) {
+  return false;
+}
+
+void year_close(void) {
+}
+
+const YearTable *year_table(void) {
+  return NULL;
+}
+
+bool year_has(uint16_t index) {
+  return false;
+}
+
+void year_start_stream(uint8_t chunk_days) {
+}
+
+void year_fill_local(const SolarLocation *loc) {
+}
+
+bool year_wants_send(void) {
+  return false;
+}
+
+void year_write(DictionaryIterator *iter, int32_t today) {
+}
+
+void year_on_send_failed(void) {
+}
+
+void year_on_chunk(const uint8_t *data, uint16_t length, uint16_t stream) {
+}
+
+bool refresh_read_report(WorkerReport *out) {
+  return false;
+}
+
+void glance_publish(const SolarLocation *loc, SolarFields fields, int32_t today) {
+}
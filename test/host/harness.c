@@ -0,0 +1,375 @@
+// Scripted runs of the watch side (msg.c and the modules under it) against
+// the simulated link and phone, reporting what a user would feel:
+//
+//   harness [-v] script
+//
+// A script is one run, one command per line; # starts a comment.
+//
+//   start YYYY-MM-DD HH:MM   local time the run starts at (before launch)
+//   seed N                   for the link's faults
+//   link latency=MS jitter=MS drop=PCT busy=PCT reorder=PCT
+//   phone lat=DEG lon=DEG fix=MS answer=MS
+//   phone-only on|off        every day has to come over the link
+//   heap BYTES               heap_bytes_free() at launch
+//   launch                   start the app with the phone connected (once)
+//   fields MASK              the phone pushes a new SolarFields mask
+//   press up|down|select|long
+//   hold up|down N           N clicks at the button repeat rate
+//   wait MS
+//   midnight                 run to just past the next local midnight
+//   disconnect | connect
+//   exit                     close the app, as on the way out
+//   expect painted=PCT p95=MS hits=PCT
+//                            fail the run unless at least PCT% of presses
+//                            were painted, p95 press->paint is at most MS and
+//                            the cache hit rate is at least PCT% at the end
+
+#include <pebble.h>
+#include "sim.h"
+#include "phone.h"
+#include "msg.h"
+#include "ui.h"
+#include "cache.h"
+#include "stats.h"
+#include "lowmem.h"
+
+#define BUTTON_REPEAT_MS 180   // window_single_repeating_click_subscribe() in Helios.c
+#define MAX_SAMPLES 4096
+
+// Press -> ui_show_daytimes() of the day it asked for. A press overtaken by
+// the next one before its day is painted is counted as superseded instead.
+static struct {
+  bool waiting;
+  uint32_t at;
+  int32_t day;
+} s_press;
+
+static uint32_t s_samples[MAX_SAMPLES];
+static uint32_t s_sample_count = 0;
+static uint32_t s_presses = 0;
+static uint32_t s_superseded = 0;
+static uint32_t s_paints = 0;
+static uint32_t s_statuses = 0;
+
+static bool s_phone_only = false;
+static bool s_launched = false;
+static bool s_exited = false;
+static bool s_verbose = false;
+
+// Acceptance thresholds from `expect`, -1 for none
+static long s_expect_painted = -1;
+static long s_expect_p95 = -1;
+static long s_expect_hits = -1;
+
+// ui.h, recording instead of drawing
+
+void ui_show_status(const char *text) {
+  s_statuses++;
+  if (s_verbose) printf("%8u ms  status \"%s\"\n", (unsigned)sim_now(), text);
+}
+
+void ui_show_status_detail(const char *what, const char *detail) {
+  s_statuses++;
+  if (s_verbose) printf("%8u ms  status \"%s: %s\"\n", (unsigned)sim_now(), what, detail);
+}
+
+void ui_show_daytimes(const DayTimes *dt) {
+  stats_mark_paint();
+  s_paints++;
+  if (s_verbose) printf("%8u ms  paint day %d\n", (unsigned)sim_now(), (int)dt->day);
+  if (s_press.waiting && dt->day == s_press.day) {
+    s_press.waiting = false;
+    if (s_sample_count < MAX_SAMPLES) s_samples[s_sample_count++] = sim_now() - s_press.at;
+  }
+}
+
+void ui_flash_title(const char *text) {
+}
+
+void ui_set_fields(SolarFields fields) {
+}
+
+void ui_set_transition(int8_t direction) {
+}
+
+void ui_relayout(void) {
+}
+
+// scenario.h: faults live in the link, so only phone-only is left to say
+
+bool scenario_drop_reply(void) {
+  return false;
+}
+
+bool scenario_outbox_busy(void) {
+  return false;
+}
+
+bool scenario_phone_only(void) {
+  return s_phone_only;
+}
+
+// Buttons, as Helios.c wires them
+
+static void prv_press(const char *button) {
+  int32_t offset = msg_get_day_offset();
+  int32_t target;
+  if (strcmp(button, "up") == 0) target = offset - 1;
+  else if (strcmp(button, "down") == 0) target = offset + 1;
+  else if (strcmp(button, "select") == 0) target = 0;
+  else {
+    msg_cycle_place();
+    return;
+  }
+
+  s_presses++;
+  if (s_press.waiting) s_superseded++;
+  s_press.waiting = true;
+  s_press.at = sim_now();
+  s_press.day = msg_get_today() + target;
+  msg_navigate_to_offset(target);
+}
+
+static void prv_connect(bool connected) {
+  sim_set_connected(connected);
+  msg_on_phone_conn_changed(connected);
+  if (connected) phone_connect();
+}
+
+static void prv_midnight(void) {
+  time_t now = time(NULL);
+  struct tm next = *localtime(&now);
+  next.tm_mday++;
+  next.tm_hour = next.tm_min = next.tm_sec = 0;
+  next.tm_isdst = -1;
+  sim_run_for((uint32_t)(mktime(&next) - now) * 1000 + 1000);
+  msg_on_day_changed();
+}
+
+// Report
+
+static int prv_cmp_u32(const void *a, const void *b) {
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+  return x < y ? -1 : x > y;
+}
+
+static uint32_t prv_percentile(int pct) {
+  if (!s_sample_count) return 0;
+  uint32_t i = (s_sample_count * pct + 99) / 100;
+  return s_samples[i ? i - 1 : 0];
+}
+
+static void prv_report(const char *name) {
+  qsort(s_samples, s_sample_count, sizeof(s_samples[0]), prv_cmp_u32);
+  uint64_t sum = 0;
+  for (uint32_t i = 0; i < s_sample_count; i++) sum += s_samples[i];
+
+  const CacheStats *cache = cache_get_stats();
+  uint32_t lookups = cache->hits + cache->misses;
+  uint32_t navs = stats_get(STAT_NAV);
+  uint32_t reqs = stats_get(STAT_REQ_SENT);
+  const SimLinkStats *link = sim_link_stats();
+
+  printf("%s\n", name);
+  printf("  press->paint  %u presses: %u painted, %u superseded, %u pending\n",
+         (unsigned)s_presses, (unsigned)s_sample_count, (unsigned)s_superseded,
+         (unsigned)(s_press.waiting ? 1 : 0));
+  printf("                avg %u ms, p50 %u ms, p95 %u ms, max %u ms\n",
+         (unsigned)(s_sample_count ? sum / s_sample_count : 0),
+         (unsigned)prv_percentile(50), (unsigned)prv_percentile(95),
+         (unsigned)(s_sample_count ? s_samples[s_sample_count - 1] : 0));
+  printf("  cache         %u hits, %u misses, %u.%u%% hit rate (width %u)\n",
+         (unsigned)cache->hits, (unsigned)cache->misses,
+         (unsigned)(lookups ? cache->hits * 100 / lookups : 0),
+         (unsigned)(lookups ? cache->hits * 1000 / lookups % 10 : 0), (unsigned)cache_width());
+  printf("  messages      %u REQs for %u navigations (%u.%02u per nav), %u replies, %u phone REQs\n",
+         (unsigned)reqs, (unsigned)navs,
+         (unsigned)(navs ? reqs / navs : 0), (unsigned)(navs ? reqs * 100 / navs % 100 : 0),
+         (unsigned)stats_get(STAT_REPLY), (unsigned)phone_requests());
+  printf("  link          %u sent, %u busy, %u failed, %u lost, %u reordered, %u received, "
+         "%u overflowed; largest %u of %u inbox bytes\n",
+         (unsigned)link->sent, (unsigned)link->busy, (unsigned)link->failed, (unsigned)link->lost,
+         (unsigned)link->reordered, (unsigned)link->received, (unsigned)link->overflow,
+         (unsigned)link->largest, (unsigned)sim_inbox_size());
+  printf("  retries       %u\n", (unsigned)stats_get(STAT_RETRY));
+  printf("  screen        %u paints, %u status messages\n", (unsigned)s_paints, (unsigned)s_statuses);
+}
+
+// After prv_report(), which sorts the samples
+static bool prv_meets_expectations(void) {
+  bool ok = true;
+  const CacheStats *cache = cache_get_stats();
+  uint32_t lookups = cache->hits + cache->misses;
+  uint32_t painted = s_presses ? s_sample_count * 100 / s_presses : 100;
+  uint32_t hits = lookups ? cache->hits * 100 / lookups : 100;
+  if (s_expect_painted >= 0 && painted < (uint32_t)s_expect_painted) {
+    printf("  FAIL          %u%% of presses painted, expected at least %ld%%\n", (unsigned)painted, s_expect_painted);
+    ok = false;
+  }
+  if (s_expect_p95 >= 0 && prv_percentile(95) > (uint32_t)s_expect_p95) {
+    printf("  FAIL          p95 press->paint %u ms, expected at most %ld ms\n", (unsigned)prv_percentile(95), s_expect_p95);
+    ok = false;
+  }
+  if (s_expect_hits >= 0 && hits < (uint32_t)s_expect_hits) {
+    printf("  FAIL          %u%% cache hit rate, expected at least %ld%%\n", (unsigned)hits, s_expect_hits);
+    ok = false;
+  }
+  return ok;
+}
+
+// Script
+
+static bool prv_pair(char *arg, const char *key, long *out) {
+  size_t n = strlen(key);
+  if (strncmp(arg, key, n) != 0 || arg[n] != '=') return false;
+  *out = strtol(arg + n + 1, NULL, 10);
+  return true;
+}
+
+static bool prv_pair_deg(char *arg, const char *key, int32_t *out_e6) {
+  size_t n = strlen(key);
+  if (strncmp(arg, key, n) != 0 || arg[n] != '=') return false;
+  *out_e6 = (int32_t)lround(strtod(arg + n + 1, NULL) * 1e6);
+  return true;
+}
+
+static bool prv_launched(const char *path, int line, const char *cmd) {
+  if (s_launched && !s_exited) return true;
+  fprintf(stderr, "%s:%d: %s needs the app running\n", path, line, cmd);
+  return false;
+}
+
+int main(int argc, char **argv) {
+  const char *path = NULL;
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "-v") == 0) s_verbose = true;
+    else path = argv[i];
+  }
+  if (!path) {
+    fprintf(stderr, "usage: %s [-v] script\n", argv[0]);
+    return 2;
+  }
+  FILE *f = fopen(path, "r");
+  if (!f) {
+    perror(path);
+    return 2;
+  }
+
+  // Defaults: Berlin in June, a good link and a phone with a warm fix
+  struct tm start = { .tm_year = 2026 - 1900, .tm_mon = 5, .tm_mday = 1, .tm_hour = 9, .tm_isdst = -1 };
+  uint32_t seed = 1;
+  SimLink link = { .latency_ms = 60, .jitter_ms = 20 };
+  PhoneConfig phone = { .lat_e6 = 52520000, .lon_e6 = 13405000, .fix_ms = 1500, .answer_ms = 40 };
+  size_t heap = 40000;
+
+  char buf[256];
+  int line = 0;
+  bool ok = true;
+  while (ok && fgets(buf, sizeof(buf), f)) {
+    line++;
+    char *hash = strchr(buf, '#');
+    if (hash) *hash = 0;
+    char *args[8];
+    int n = 0;
+    for (char *tok = strtok(buf, " \t\r\n"); tok && n < 8; tok = strtok(NULL, " \t\r\n")) args[n++] = tok;
+    if (!n) continue;
+    const char *cmd = args[0];
+
+    if (strcmp(cmd, "start") == 0 && n == 3 && !s_launched) {
+      ok = sscanf(args[1], "%d-%d-%d", &start.tm_year, &start.tm_mon, &start.tm_mday) == 3 &&
+           sscanf(args[2], "%d:%d", &start.tm_hour, &start.tm_min) == 2;
+      start.tm_year -= 1900;
+      start.tm_mon -= 1;
+    } else if (strcmp(cmd, "seed") == 0 && n == 2 && !s_launched) {
+      seed = (uint32_t)strtoul(args[1], NULL, 10);
+    } else if (strcmp(cmd, "link") == 0) {
+      for (int i = 1; i < n; i++) {
+        long v;
+        if (prv_pair(args[i], "latency", &v)) link.latency_ms = (uint16_t)v;
+        else if (prv_pair(args[i], "jitter", &v)) link.jitter_ms = (uint16_t)v;
+        else if (prv_pair(args[i], "drop", &v)) link.drop_pct = (uint8_t)v;
+        else if (prv_pair(args[i], "busy", &v)) link.busy_pct = (uint8_t)v;
+        else if (prv_pair(args[i], "reorder", &v)) link.reorder_pct = (uint8_t)v;
+        else ok = false;
+      }
+      if (s_launched) sim_link_set(&link);
+    } else if (strcmp(cmd, "phone") == 0 && !s_launched) {
+      for (int i = 1; i < n; i++) {
+        long v;
+        if (prv_pair_deg(args[i], "lat", &phone.lat_e6) || prv_pair_deg(args[i], "lon", &phone.lon_e6)) continue;
+        if (prv_pair(args[i], "fix", &v)) phone.fix_ms = (uint16_t)v;
+        else if (prv_pair(args[i], "answer", &v)) phone.answer_ms = (uint16_t)v;
+        else ok = false;
+      }
+    } else if (strcmp(cmd, "phone-only") == 0 && n == 2) {
+      s_phone_only = strcmp(args[1], "on") == 0;
+    } else if (strcmp(cmd, "heap") == 0 && n == 2 && !s_launched) {
+      heap = (size_t)strtoul(args[1], NULL, 10);
+    } else if (strcmp(cmd, "launch") == 0 && !s_launched) {
+      sim_reset(mktime(&start), seed);
+      sim_set_verbose(s_verbose);
+      sim_link_set(&link);
+      sim_set_heap_free(heap);
+      phone_reset(&phone);
+      s_launched = true;
+      // Helios.c's init()
+      lowmem_init();
+      msg_init();
+      msg_start_worker();
+      prv_connect(true);
+    } else if (strcmp(cmd, "fields") == 0 && n == 2) {
+      ok = prv_launched(path, line, cmd);
+      if (ok) phone_set_fields((SolarFields)strtoul(args[1], NULL, 0));
+    } else if (strcmp(cmd, "press") == 0 && n == 2) {
+      ok = prv_launched(path, line, cmd);
+      if (ok) prv_press(args[1]);
+    } else if (strcmp(cmd, "hold") == 0 && n == 3) {
+      ok = prv_launched(path, line, cmd);
+      for (long i = strtol(args[2], NULL, 10); ok && i > 0; i--) {
+        prv_press(args[1]);
+        sim_run_for(BUTTON_REPEAT_MS);
+      }
+    } else if (strcmp(cmd, "wait") == 0 && n == 2) {
+      ok = prv_launched(path, line, cmd);
+      if (ok) sim_run_for((uint32_t)strtoul(args[1], NULL, 10));
+    } else if (strcmp(cmd, "midnight") == 0) {
+      ok = prv_launched(path, line, cmd);
+      if (ok) prv_midnight();
+    } else if (strcmp(cmd, "connect") == 0 || strcmp(cmd, "disconnect") == 0) {
+      ok = prv_launched(path, line, cmd);
+      if (ok) prv_connect(strcmp(cmd, "connect") == 0);
+    } else if (strcmp(cmd, "expect") == 0) {
+      for (int i = 1; i < n; i++) {
+        if (!prv_pair(args[i], "painted", &s_expect_painted) && !prv_pair(args[i], "p95", &s_expect_p95) &&
+            !prv_pair(args[i], "hits", &s_expect_hits)) {
+          ok = false;
+        }
+      }
+    } else if (strcmp(cmd, "exit") == 0) {
+      ok = prv_launched(path, line, cmd);
+      if (ok) {
+        msg_deinit();
+        s_exited = true;
+      }
+    } else {
+      fprintf(stderr, "%s:%d: cannot do \"%s\" here\n", path, line, cmd);
+      ok = false;
+    }
+  }
+  fclose(f);
+  if (!ok) {
+    fprintf(stderr, "%s:%d: script error\n", path, line);
+    return 2;
+  }
+  if (!s_launched) {
+    fprintf(stderr, "%s: never launched\n", path);
+    return 2;
+  }
+
+  const char *name = strrchr(path, '/');
+  prv_report(name ? name + 1 : path);
+
+  // A reply the inbox cannot hold means the buffer sizing is wrong
+  bool met = prv_meets_expectations();
+  return sim_link_stats()->overflow || !met ? 1 : 0;
+}
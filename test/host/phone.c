@@ -0,0 +1,161 @@
+#include <pebble.h>
+#include "phone.h"
+#include "sim.h"
+#include "wire.h"
+
+#define PHONE_DICT_MAX 2048
+
+typedef struct {
+  int32_t seq;
+  int32_t center;
+  int32_t count;
+  SolarFields fields;
+} PhoneRequest;
+
+static PhoneConfig s_config;
+static bool s_have_fix = false;
+static SolarFields s_fields = 0;    // pushed with the settings, 0 for none
+static uint32_t s_requests = 0;
+
+static void prv_put_u16(uint8_t *p, uint16_t v) {
+  p[0] = v & 0xff;
+  p[1] = v >> 8;
+}
+
+static void prv_put_i32(uint8_t *p, int32_t v) {
+  for (int i = 0; i < 4; i++) p[i] = ((uint32_t)v >> (8 * i)) & 0xff;
+}
+
+// The zone's next offset change within a year, as index.js works it out
+static void prv_next_zone_change(time_t now, int32_t *change, int32_t *offset) {
+  long tz = localtime(&now)->tm_gmtoff;
+  *change = 0;
+  *offset = (int32_t)tz;
+  for (int day = 1; day <= 366; day++) {
+    time_t hi = now + (time_t)day * SECONDS_PER_DAY;
+    if (localtime(&hi)->tm_gmtoff == tz) continue;
+    time_t lo = hi - SECONDS_PER_DAY;
+    while (hi - lo > SECONDS_PER_MINUTE) {
+      time_t mid = lo + (hi - lo) / 2;
+      if (localtime(&mid)->tm_gmtoff == tz) lo = mid;
+      else hi = mid;
+    }
+    hi -= hi % SECONDS_PER_MINUTE;
+    *change = (int32_t)hi;
+    *offset = (int32_t)localtime(&hi)->tm_gmtoff;
+    return;
+  }
+}
+
+static void prv_reply_cb(void *data) {
+  PhoneRequest *req = data;
+  SolarLocation loc = {
+    .lat_e6 = s_config.lat_e6,
+    .lon_e6 = s_config.lon_e6,
+    .zone_change = SOLAR_ZONE_WATCH,
+  };
+  time_t now = time(NULL);
+  int32_t today = solar_local_day(&loc, now);
+  loc.utc_offset = solar_offset_on(&loc, today);
+
+  SolarFields fields = solar_fields_clamp(req->fields ? req->fields : SOLAR_FIELDS_CLASSIC);
+  uint8_t n = solar_field_count(fields);
+  uint8_t count = req->count < 1 ? 1 : req->count > 255 ? 255 : (uint8_t)req->count;
+  int16_t first = (int16_t)(req->center - count / 2);
+
+  // Bundle, wire.h version 3
+  uint16_t size = 10 + count * n * 2;
+  uint8_t *bundle = malloc(size);
+  bundle[0] = 3;
+  bundle[1] = count;
+  prv_put_u16(&bundle[2], (uint16_t)first);
+  prv_put_i32(&bundle[4], today);
+  prv_put_u16(&bundle[8], fields);
+  for (uint8_t i = 0; i < count; i++) {
+    SolarDay sd;
+    solar_compute_day(&loc, fields, today + first + i, &sd);
+    for (uint8_t f = 0; f < n; f++) {
+      int16_t m = sd.minutes[f];
+      prv_put_u16(&bundle[10 + (i * n + f) * 2], m == SOLAR_NONE ? WIRE_NONE : (uint16_t)m);
+    }
+  }
+
+  int32_t change, next_offset;
+  prv_next_zone_change(now, &change, &next_offset);
+  int32_t epoch = 0;
+
+  uint8_t buf[PHONE_DICT_MAX];
+  DictionaryIterator iter;
+  dict_write_begin(&iter, buf, sizeof(buf));
+  dict_write_int(&iter, MESSAGE_KEY_SEQ, &req->seq, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_EPOCH, &epoch, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_LAT, &loc.lat_e6, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_LON, &loc.lon_e6, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_UTC_OFFSET, &loc.utc_offset, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_UTC_CHANGE, &change, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_UTC_OFFSET_NEXT, &next_offset, sizeof(int32_t), true);
+  dict_write_data(&iter, MESSAGE_KEY_BUNDLE, bundle, size);
+  uint32_t length = dict_write_end(&iter);
+  free(bundle);
+  free(req);
+
+  sim_phone_send(buf, (uint16_t)length);
+}
+
+static int32_t prv_int(DictionaryIterator *iter, uint32_t key, int32_t fallback) {
+  Tuple *t = dict_find(iter, key);
+  return t ? t->value->int32 : fallback;
+}
+
+void phone_receive(DictionaryIterator *iter) {
+  if (!dict_find(iter, MESSAGE_KEY_REQ)) return;   // year stream: not simulated
+
+  PhoneRequest *req = malloc(sizeof(PhoneRequest));
+  req->seq = prv_int(iter, MESSAGE_KEY_SEQ, 0);
+  req->center = prv_int(iter, MESSAGE_KEY_OFFSET, 0);
+  req->count = prv_int(iter, MESSAGE_KEY_COUNT, 3);
+  req->fields = (SolarFields)prv_int(iter, MESSAGE_KEY_FIELDS, 0);
+  s_requests++;
+
+  sim_schedule(s_have_fix ? s_config.answer_ms : s_config.fix_ms, prv_reply_cb, req);
+  s_have_fix = true;
+}
+
+static void prv_send_settings(void) {
+  int32_t fields = s_fields;
+  int32_t worker = 0;
+  uint8_t buf[64];
+  DictionaryIterator iter;
+  dict_write_begin(&iter, buf, sizeof(buf));
+  dict_write_int(&iter, MESSAGE_KEY_FIELDS, &fields, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_WORKER, &worker, sizeof(int32_t), true);
+  sim_phone_send(buf, (uint16_t)dict_write_end(&iter));
+}
+
+void phone_connect(void) {
+  int32_t one = 1;
+  int32_t proto = WIRE_VERSION;
+  uint8_t buf[64];
+  DictionaryIterator iter;
+  dict_write_begin(&iter, buf, sizeof(buf));
+  dict_write_int(&iter, MESSAGE_KEY_HELLO, &one, sizeof(int32_t), true);
+  dict_write_int(&iter, MESSAGE_KEY_PROTO, &proto, sizeof(int32_t), true);
+  sim_phone_send(buf, (uint16_t)dict_write_end(&iter));
+  if (s_fields) prv_send_settings();
+}
+
+void phone_set_fields(SolarFields fields) {
+  s_fields = fields;
+  prv_send_settings();
+}
+
+uint32_t phone_requests(void) {
+  return s_requests;
+}
+
+void phone_reset(const PhoneConfig *config) {
+  s_config = *config;
+  s_have_fix = false;
+  s_fields = 0;
+  s_requests = 0;
+}
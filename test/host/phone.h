@@ -0,0 +1,25 @@
+#pragma once
+#include <pebble.h>
+#include "solar.h"
+
+// Stand-in for src/pkjs: says HELLO when the link comes up and answers each
+// REQ with a version 3 bundle computed by solar.c for its own fix. It never
+// sends patches (EPOCH is always 0), so every reply is a full bundle.
+
+typedef struct {
+  int32_t lat_e6;
+  int32_t lon_e6;
+  uint16_t fix_ms;        // first REQ: waiting for geolocation
+  uint16_t answer_ms;     // later REQs
+} PhoneConfig;
+
+void phone_reset(const PhoneConfig *config);
+
+// The phone app started with the link up: HELLO, then settings if any
+void phone_connect(void);
+
+// Push a FIELDS setting, as the config page does when it is saved
+void phone_set_fields(SolarFields fields);
+
+// REQs answered so far
+uint32_t phone_requests(void);
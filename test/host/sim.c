@@ -0,0 +1,561 @@
+#include <pebble.h>
+#include <stdarg.h>
+#include "sim.h"
+
+#undef time
+
+// Roughly how long the firmware waits for the phone to ack a message
+#define SIM_SEND_TIMEOUT_MS 3000
+
+#define SIM_INBOX_MAX  8200
+#define SIM_OUTBOX_MAX 8200
+#define SIM_PERSIST_SLOTS 32
+
+// Events: timers and message legs share one queue ordered by time, then by
+// when they were scheduled
+struct AppTimer {
+  uint32_t at;
+  uint32_t order;
+  SimCallback callback;
+  void *data;
+  struct AppTimer *next;
+};
+
+static struct AppTimer *s_queue = NULL;
+static uint32_t s_now = 0;
+static uint32_t s_order = 0;
+static time_t s_start_utc = 0;
+static uint32_t s_rng = 1;
+static size_t s_heap_free = 40000;
+static bool s_verbose = false;
+
+static void prv_insert(struct AppTimer *ev) {
+  struct AppTimer **p = &s_queue;
+  while (*p && ((*p)->at < ev->at || ((*p)->at == ev->at && (*p)->order < ev->order))) p = &(*p)->next;
+  ev->next = *p;
+  *p = ev;
+}
+
+static bool prv_unlink(struct AppTimer *ev) {
+  for (struct AppTimer **p = &s_queue; *p; p = &(*p)->next) {
+    if (*p == ev) {
+      *p = ev->next;
+      return true;
+    }
+  }
+  return false;
+}
+
+static struct AppTimer *prv_schedule(uint32_t delay_ms, SimCallback callback, void *data) {
+  struct AppTimer *ev = malloc(sizeof(*ev));
+  ev->at = s_now + delay_ms;
+  ev->order = s_order++;
+  ev->callback = callback;
+  ev->data = data;
+  prv_insert(ev);
+  return ev;
+}
+
+void sim_schedule(uint32_t delay_ms, SimCallback callback, void *data) {
+  prv_schedule(delay_ms, callback, data);
+}
+
+uint32_t sim_now(void) {
+  return s_now;
+}
+
+void sim_run_for(uint32_t ms) {
+  uint32_t until = s_now + ms;
+  while (s_queue && s_queue->at <= until) {
+    struct AppTimer *ev = s_queue;
+    s_queue = ev->next;
+    s_now = ev->at;
+    SimCallback callback = ev->callback;
+    void *data = ev->data;
+    free(ev);
+    callback(data);
+  }
+  s_now = until;
+}
+
+uint32_t sim_random(uint32_t n) {
+  // xorshift32
+  s_rng ^= s_rng << 13;
+  s_rng ^= s_rng >> 17;
+  s_rng ^= s_rng << 5;
+  return n ? s_rng % n : 0;
+}
+
+void sim_set_heap_free(size_t bytes) {
+  s_heap_free = bytes;
+}
+
+void sim_set_verbose(bool verbose) {
+  s_verbose = verbose;
+}
+
+// SDK: clock, heap, log
+
+time_t sim_time(time_t *tloc) {
+  time_t t = s_start_utc + s_now / 1000;
+  if (tloc) *tloc = t;
+  return t;
+}
+
+uint16_t time_ms(time_t *t_utc, uint16_t *out_ms) {
+  uint16_t ms = s_now % 1000;
+  if (t_utc) *t_utc = s_start_utc + s_now / 1000;
+  if (out_ms) *out_ms = ms;
+  return ms;
+}
+
+size_t heap_bytes_free(void) {
+  return s_heap_free;
+}
+
+void app_log(uint8_t log_level, const char *src_filename, int src_line_number, const char *fmt, ...) {
+  if (!s_verbose) return;
+  const char *base = strrchr(src_filename, '/');
+  printf("%8u ms  %s:%d  ", (unsigned)s_now, base ? base + 1 : src_filename, src_line_number);
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+  putchar('\n');
+}
+
+static void prv_trace(const char *fmt, ...) {
+  if (!s_verbose) return;
+  printf("%8u ms  link  ", (unsigned)s_now);
+  va_list args;
+  va_start(args, fmt);
+  vprintf(fmt, args);
+  va_end(args);
+  putchar('\n');
+}
+
+// SDK: timers
+
+AppTimer *app_timer_register(uint32_t timeout_ms, AppTimerCallback callback, void *callback_data) {
+  return prv_schedule(timeout_ms, callback, callback_data);
+}
+
+bool app_timer_reschedule(AppTimer *timer_handle, uint32_t new_timeout_ms) {
+  if (!prv_unlink(timer_handle)) return false;
+  timer_handle->at = s_now + new_timeout_ms;
+  timer_handle->order = s_order++;
+  prv_insert(timer_handle);
+  return true;
+}
+
+void app_timer_cancel(AppTimer *timer_handle) {
+  if (prv_unlink(timer_handle)) free(timer_handle);
+}
+
+// SDK: persist, in memory
+
+static struct {
+  bool used;
+  uint32_t key;
+  uint16_t size;
+  uint8_t data[PERSIST_DATA_MAX_LENGTH];
+} s_persist[SIM_PERSIST_SLOTS];
+
+static int prv_persist_find(uint32_t key) {
+  for (int i = 0; i < SIM_PERSIST_SLOTS; i++) {
+    if (s_persist[i].used && s_persist[i].key == key) return i;
+  }
+  return -1;
+}
+
+bool persist_exists(const uint32_t key) {
+  return prv_persist_find(key) >= 0;
+}
+
+int persist_get_size(const uint32_t key) {
+  int i = prv_persist_find(key);
+  return i < 0 ? E_DOES_NOT_EXIST : s_persist[i].size;
+}
+
+int persist_read_data(const uint32_t key, void *buffer, const size_t buffer_size) {
+  int i = prv_persist_find(key);
+  if (i < 0) return E_DOES_NOT_EXIST;
+  size_t n = s_persist[i].size < buffer_size ? s_persist[i].size : buffer_size;
+  memcpy(buffer, s_persist[i].data, n);
+  return (int)n;
+}
+
+int persist_write_data(const uint32_t key, const void *data, const size_t size) {
+  if (size > PERSIST_DATA_MAX_LENGTH) return E_INVALID_ARGUMENT;
+  int i = prv_persist_find(key);
+  for (int j = 0; i < 0 && j < SIM_PERSIST_SLOTS; j++) {
+    if (!s_persist[j].used) i = j;
+  }
+  if (i < 0) return E_ERROR;
+  s_persist[i].used = true;
+  s_persist[i].key = key;
+  s_persist[i].size = (uint16_t)size;
+  memcpy(s_persist[i].data, data, size);
+  return (int)size;
+}
+
+bool persist_read_bool(const uint32_t key) {
+  bool value = false;
+  persist_read_data(key, &value, sizeof(value));
+  return value;
+}
+
+int32_t persist_read_int(const uint32_t key) {
+  int32_t value = 0;
+  persist_read_data(key, &value, sizeof(value));
+  return value;
+}
+
+status_t persist_write_bool(const uint32_t key, const bool value) {
+  return persist_write_data(key, &value, sizeof(value)) < 0 ? E_ERROR : S_SUCCESS;
+}
+
+status_t persist_write_int(const uint32_t key, const int32_t value) {
+  return persist_write_data(key, &value, sizeof(value)) < 0 ? E_ERROR : S_SUCCESS;
+}
+
+status_t persist_delete(const uint32_t key) {
+  int i = prv_persist_find(key);
+  if (i < 0) return E_DOES_NOT_EXIST;
+  s_persist[i].used = false;
+  return S_SUCCESS;
+}
+
+// SDK: dictionaries
+
+#define TUPLE_HEADER_SIZE 7
+
+static Tuple *prv_tuple_next(const Tuple *t) {
+  return (Tuple *)((const uint8_t *)t + TUPLE_HEADER_SIZE + t->length);
+}
+
+DictionaryResult dict_write_begin(DictionaryIterator *iter, uint8_t *buffer, const uint16_t size) {
+  if (!iter || !buffer || size < 1) return DICT_INVALID_ARGS;
+  iter->dictionary = (Dictionary *)buffer;
+  iter->dictionary->count_or_end = 0;
+  iter->cursor = iter->dictionary->head;
+  iter->end = buffer + size;
+  return DICT_OK;
+}
+
+static DictionaryResult prv_write(DictionaryIterator *iter, uint32_t key, TupleType type,
+                                  const void *value, uint16_t length) {
+  if ((const uint8_t *)iter->cursor + TUPLE_HEADER_SIZE + length > (const uint8_t *)iter->end) {
+    return DICT_NOT_ENOUGH_STORAGE;
+  }
+  iter->cursor->key = key;
+  iter->cursor->type = type;
+  iter->cursor->length = length;
+  memcpy(iter->cursor->value->data, value, length);
+  iter->cursor = prv_tuple_next(iter->cursor);
+  iter->dictionary->count_or_end++;
+  return DICT_OK;
+}
+
+DictionaryResult dict_write_data(DictionaryIterator *iter, const uint32_t key, const uint8_t *data,
+                                 const uint16_t size) {
+  return prv_write(iter, key, TUPLE_BYTE_ARRAY, data, size);
+}
+
+DictionaryResult dict_write_cstring(DictionaryIterator *iter, const uint32_t key, const char *cstring) {
+  return prv_write(iter, key, TUPLE_CSTRING, cstring, (uint16_t)(strlen(cstring) + 1));
+}
+
+DictionaryResult dict_write_int(DictionaryIterator *iter, const uint32_t key, const void *integer,
+                                const uint8_t width_bytes, const bool is_signed) {
+  if (width_bytes != 1 && width_bytes != 2 && width_bytes != 4) return DICT_INVALID_ARGS;
+  return prv_write(iter, key, is_signed ? TUPLE_INT : TUPLE_UINT, integer, width_bytes);
+}
+
+DictionaryResult dict_write_uint8(DictionaryIterator *iter, const uint32_t key, const uint8_t value) {
+  return prv_write(iter, key, TUPLE_UINT, &value, 1);
+}
+
+uint32_t dict_write_end(DictionaryIterator *iter) {
+  iter->end = iter->cursor;
+  return (uint32_t)((const uint8_t *)iter->end - (const uint8_t *)iter->dictionary);
+}
+
+Tuple *dict_read_begin_from_buffer(DictionaryIterator *iter, const uint8_t *buffer, const uint16_t size) {
+  iter->dictionary = (Dictionary *)buffer;
+  iter->end = buffer + size;
+  iter->cursor = iter->dictionary->head;
+  return iter->dictionary->count_or_end ? iter->cursor : NULL;
+}
+
+Tuple *dict_read_next(DictionaryIterator *iter) {
+  Tuple *next = prv_tuple_next(iter->cursor);
+  if ((const uint8_t *)next + TUPLE_HEADER_SIZE > (const uint8_t *)iter->end) return NULL;
+  iter->cursor = next;
+  return next;
+}
+
+Tuple *dict_find(const DictionaryIterator *iter, const uint32_t key) {
+  Tuple *t = iter->dictionary->head;
+  for (uint8_t i = 0; i < iter->dictionary->count_or_end; i++) {
+    if ((const uint8_t *)t + TUPLE_HEADER_SIZE > (const uint8_t *)iter->end) break;
+    if (t->key == key) return t;
+    t = prv_tuple_next(t);
+  }
+  return NULL;
+}
+
+// SDK: AppMessage over the simulated link
+
+typedef struct {
+  uint16_t size;
+  uint8_t data[];
+} SimMessage;
+
+static SimLink s_link;
+static SimLinkStats s_link_stats;
+static bool s_connected = false;
+static uint32_t s_ordered_at[2];     // per direction: deliveries keep this order
+
+static uint32_t s_inbox_size = 0;
+static uint8_t *s_outbox = NULL;
+static uint32_t s_outbox_size = 0;
+static DictionaryIterator s_out_iter;
+static bool s_out_open = false;      // begun, not yet sent
+static SimMessage *s_out_pending = NULL;   // sent, waiting for the ack
+
+static AppMessageInboxReceived s_inbox_received = NULL;
+static AppMessageInboxDropped s_inbox_dropped = NULL;
+static AppMessageOutboxSent s_outbox_sent = NULL;
+static AppMessageOutboxFailed s_outbox_failed = NULL;
+
+enum { TO_PHONE, TO_WATCH };
+
+static bool prv_roll(uint8_t pct) {
+  return pct && sim_random(100) < pct;
+}
+
+static SimMessage *prv_copy(const uint8_t *dict, uint16_t size) {
+  SimMessage *m = malloc(sizeof(SimMessage) + size);
+  m->size = size;
+  memcpy(m->data, dict, size);
+  return m;
+}
+
+// Delay for one leg of the link in `direction`
+static uint32_t prv_leg_ms(int direction) {
+  uint32_t at = s_now + s_link.latency_ms + sim_random(s_link.jitter_ms + 1);
+  if (prv_roll(s_link.reorder_pct)) {
+    s_link_stats.reordered++;
+    return at - s_now + 3 * s_link.latency_ms + 100;
+  }
+  if (at < s_ordered_at[direction]) at = s_ordered_at[direction];
+  s_ordered_at[direction] = at;
+  return at - s_now;
+}
+
+static void prv_outbox_done(AppMessageResult result) {
+  SimMessage *m = s_out_pending;
+  s_out_pending = NULL;
+  if (!m) return;
+  DictionaryIterator iter;
+  dict_read_begin_from_buffer(&iter, m->data, m->size);
+  if (result == APP_MSG_OK) {
+    if (s_outbox_sent) s_outbox_sent(&iter, NULL);
+  } else {
+    prv_trace("outbox failed: %d", (int)result);
+    s_link_stats.failed++;
+    if (s_outbox_failed) s_outbox_failed(&iter, result, NULL);
+  }
+  free(m);
+}
+
+static void prv_ack_cb(void *data) {
+  prv_outbox_done(APP_MSG_OK);
+}
+
+static void prv_timeout_cb(void *data) {
+  prv_outbox_done(APP_MSG_SEND_TIMEOUT);
+}
+
+static void prv_not_connected_cb(void *data) {
+  prv_outbox_done(APP_MSG_NOT_CONNECTED);
+}
+
+static void prv_phone_arrival_cb(void *data) {
+  SimMessage *m = data;
+  DictionaryIterator iter;
+  dict_read_begin_from_buffer(&iter, m->data, m->size);
+  prv_trace("phone got %u bytes", (unsigned)m->size);
+  phone_receive(&iter);
+  free(m);
+  sim_schedule(prv_leg_ms(TO_WATCH), prv_ack_cb, NULL);
+}
+
+static void prv_watch_arrival_cb(void *data) {
+  SimMessage *m = data;
+  prv_trace("watch got %u bytes", (unsigned)m->size);
+  if (!s_inbox_size || m->size > s_inbox_size) {
+    s_link_stats.overflow++;
+    if (s_inbox_dropped) s_inbox_dropped(APP_MSG_BUFFER_OVERFLOW, NULL);
+  } else if (s_inbox_received) {
+    s_link_stats.received++;
+    DictionaryIterator iter;
+    dict_read_begin_from_buffer(&iter, m->data, m->size);
+    s_inbox_received(&iter, NULL);
+  }
+  free(m);
+}
+
+void sim_link_set(const SimLink *link) {
+  s_link = *link;
+}
+
+const SimLinkStats *sim_link_stats(void) {
+  return &s_link_stats;
+}
+
+void sim_set_connected(bool connected) {
+  s_connected = connected;
+}
+
+bool sim_connected(void) {
+  return s_connected;
+}
+
+uint32_t sim_inbox_size(void) {
+  return s_inbox_size;
+}
+
+void sim_phone_send(const uint8_t *dict, uint16_t size) {
+  if (!s_connected) return;
+  if (size > s_link_stats.largest) s_link_stats.largest = size;
+  if (prv_roll(s_link.drop_pct)) {
+    prv_trace("lost %u bytes to the watch", (unsigned)size);
+    s_link_stats.lost++;
+    return;
+  }
+  sim_schedule(prv_leg_ms(TO_WATCH), prv_watch_arrival_cb, prv_copy(dict, size));
+}
+
+AppMessageResult app_message_open(const uint32_t size_inbound, const uint32_t size_outbound) {
+  if (size_inbound > SIM_INBOX_MAX || size_outbound > SIM_OUTBOX_MAX) return APP_MSG_OUT_OF_MEMORY;
+  free(s_outbox);
+  s_inbox_size = size_inbound;
+  s_outbox_size = size_outbound;
+  s_outbox = malloc(size_outbound);
+  return APP_MSG_OK;
+}
+
+void app_message_deregister_callbacks(void) {
+  s_inbox_received = NULL;
+  s_inbox_dropped = NULL;
+  s_outbox_sent = NULL;
+  s_outbox_failed = NULL;
+}
+
+AppMessageInboxReceived app_message_register_inbox_received(AppMessageInboxReceived received_callback) {
+  AppMessageInboxReceived old = s_inbox_received;
+  s_inbox_received = received_callback;
+  return old;
+}
+
+AppMessageInboxDropped app_message_register_inbox_dropped(AppMessageInboxDropped dropped_callback) {
+  AppMessageInboxDropped old = s_inbox_dropped;
+  s_inbox_dropped = dropped_callback;
+  return old;
+}
+
+AppMessageOutboxSent app_message_register_outbox_sent(AppMessageOutboxSent sent_callback) {
+  AppMessageOutboxSent old = s_outbox_sent;
+  s_outbox_sent = sent_callback;
+  return old;
+}
+
+AppMessageOutboxFailed app_message_register_outbox_failed(AppMessageOutboxFailed failed_callback) {
+  AppMessageOutboxFailed old = s_outbox_failed;
+  s_outbox_failed = failed_callback;
+  return old;
+}
+
+uint32_t app_message_inbox_size_maximum(void) {
+  return SIM_INBOX_MAX;
+}
+
+uint32_t app_message_outbox_size_maximum(void) {
+  return SIM_OUTBOX_MAX;
+}
+
+AppMessageResult app_message_outbox_begin(DictionaryIterator **iterator) {
+  if (!s_outbox) return APP_MSG_INVALID_STATE;
+  if (s_out_pending || s_out_open || prv_roll(s_link.busy_pct)) {
+    s_link_stats.busy++;
+    prv_trace("outbox busy");
+    return APP_MSG_BUSY;
+  }
+  dict_write_begin(&s_out_iter, s_outbox, (uint16_t)s_outbox_size);
+  s_out_open = true;
+  *iterator = &s_out_iter;
+  return APP_MSG_OK;
+}
+
+AppMessageResult app_message_outbox_send(void) {
+  if (!s_out_open) return APP_MSG_INVALID_STATE;
+  s_out_open = false;
+  uint16_t size = (uint16_t)((const uint8_t *)s_out_iter.end - s_outbox);
+  s_out_pending = prv_copy(s_outbox, size);
+  s_link_stats.sent++;
+
+  if (!s_connected) {
+    sim_schedule(0, prv_not_connected_cb, NULL);
+  } else if (prv_roll(s_link.drop_pct)) {
+    prv_trace("lost %u bytes to the phone", (unsigned)size);
+    s_link_stats.lost++;
+    sim_schedule(SIM_SEND_TIMEOUT_MS, prv_timeout_cb, NULL);
+  } else {
+    sim_schedule(prv_leg_ms(TO_PHONE), prv_phone_arrival_cb, prv_copy(s_outbox, size));
+  }
+  return APP_MSG_OK;
+}
+
+// SDK: background worker
+
+bool app_worker_is_running(void) {
+  return false;
+}
+
+AppWorkerResult app_worker_launch(void) {
+  return APP_WORKER_RESULT_NO_WORKER;
+}
+
+AppWorkerResult app_worker_kill(void) {
+  return APP_WORKER_RESULT_NO_WORKER;
+}
+
+void app_worker_send_message(uint8_t type, AppWorkerMessage *data) {
+}
+
+void sim_reset(time_t start_utc, uint32_t seed) {
+  while (s_queue) {
+    struct AppTimer *ev = s_queue;
+    s_queue = ev->next;
+    free(ev);
+  }
+  s_now = 0;
+  s_order = 0;
+  s_start_utc = start_utc;
+  s_rng = seed ? seed : 1;
+  memset(s_persist, 0, sizeof(s_persist));
+
+  s_link = (SimLink) { 0 };
+  s_link_stats = (SimLinkStats) { 0 };
+  s_connected = false;
+  s_ordered_at[TO_PHONE] = s_ordered_at[TO_WATCH] = 0;
+  free(s_outbox);
+  s_outbox = NULL;
+  s_inbox_size = s_outbox_size = 0;
+  s_out_open = false;
+  free(s_out_pending);
+  s_out_pending = NULL;
+  app_message_deregister_callbacks();
+}
@@ -0,0 +1,66 @@
+#pragma once
+#include <pebble.h>
+
+// Host simulator behind pebble.h: a virtual millisecond clock with one event
+// queue for timers and message deliveries, persist in memory, and a fake
+// AppMessage link to the phone in phone.c. Nothing runs in real time.
+
+typedef void (*SimCallback)(void *data);
+
+// Start over at `start_utc` with an empty queue, empty flash and a fresh link
+void sim_reset(time_t start_utc, uint32_t seed);
+
+// Milliseconds since sim_reset()
+uint32_t sim_now(void);
+
+// Run everything due in the next `ms`, then leave the clock there
+void sim_run_for(uint32_t ms);
+
+// Schedule a one-off callback; what app_timer_register() and the link use
+void sim_schedule(uint32_t delay_ms, SimCallback callback, void *data);
+
+// Uniform in [0, n), from the simulator's own generator so the app's use of
+// rand() does not shift the faults
+uint32_t sim_random(uint32_t n);
+
+// Link between watch and phone. Latency is one way; both directions keep
+// their order unless a message is picked for reordering.
+typedef struct {
+  uint16_t latency_ms;
+  uint16_t jitter_ms;     // added to each message, uniform in [0, jitter_ms]
+  uint8_t drop_pct;       // messages lost, either direction
+  uint8_t busy_pct;       // app_message_outbox_begin() answers BUSY anyway
+  uint8_t reorder_pct;    // held back long enough for the next ones to overtake
+} SimLink;
+
+typedef struct {
+  uint32_t sent;          // watch -> phone sends
+  uint32_t busy;          // outbox_begin() refused with BUSY, injected or not
+  uint32_t failed;        // outbox_failed callbacks
+  uint32_t received;      // phone -> watch messages handed to the inbox
+  uint32_t lost;          // dropped by the link, either direction
+  uint32_t reordered;
+  uint32_t overflow;      // did not fit the inbox the app opened
+  uint32_t largest;       // largest phone -> watch message, bytes
+} SimLinkStats;
+
+void sim_link_set(const SimLink *link);
+const SimLinkStats *sim_link_stats(void);
+
+void sim_set_connected(bool connected);
+bool sim_connected(void);
+
+// Bytes the app opened its inbox with, 0 before app_message_open()
+uint32_t sim_inbox_size(void);
+
+// heap_bytes_free() from now on
+void sim_set_heap_free(size_t bytes);
+
+// Print APP_LOG output, stamped with the simulated time
+void sim_set_verbose(bool verbose);
+
+// Phone side of the link: send a finished dictionary to the watch
+void sim_phone_send(const uint8_t *dict, uint16_t size);
+
+// Implemented by the phone: a message from the watch arrived
+void phone_receive(DictionaryIterator *iter);
@@ -0,0 +1,77 @@
+// Checks solar.c against SunCalc: reads suncalc_ref.js's lines on stdin and
+// fails if any event is more than TOLERANCE minutes off, or happens on one
+// side only.
+
+#include <pebble.h>
+#include "solar.h"
+
+#define TOLERANCE 1
+
+// Field masks of at most SOLAR_MAX_FIELDS fields covering them all
+static const SolarFields MASKS[] = { 0x001f, 0x03e0, 0x1c00 };
+
+static int prv_distance(int a, int b) {
+  int d = abs(a - b);
+  return d > 720 ? 1440 - d : d;
+}
+
+int main(void) {
+  static const char *names[SOLAR_FIELD_COUNT] = {
+    "astro dawn", "nautical dawn", "dawn", "blue end", "sunrise", "golden end", "noon",
+    "golden start", "sunset", "blue start", "dusk", "nautical dusk", "astro dusk",
+  };
+  long lat, lon, day;
+  char zone[16];
+  int lines = 0, events = 0, failures = 0, worst = 0;
+
+  while (scanf("%ld %ld %15s %ld", &lat, &lon, zone, &day) == 4) {
+    int ref[SOLAR_FIELD_COUNT];
+    for (int f = 0; f < SOLAR_FIELD_COUNT; f++) {
+      if (scanf("%d", &ref[f]) != 1) {
+        fprintf(stderr, "short line %d\n", lines + 1);
+        return 2;
+      }
+    }
+    lines++;
+
+    SolarLocation loc = { .lat_e6 = (int32_t)lat, .lon_e6 = (int32_t)lon };
+    if (strcmp(zone, "watch") == 0) {
+      loc.zone_change = SOLAR_ZONE_WATCH;
+    } else {
+      loc.utc_offset = atoi(zone);
+    }
+
+    int got[SOLAR_FIELD_COUNT];
+    for (unsigned m = 0; m < ARRAY_LENGTH(MASKS); m++) {
+      SolarDay out;
+      solar_compute_day(&loc, MASKS[m], (int32_t)day, &out);
+      for (int f = 0; f < SOLAR_FIELD_COUNT; f++) {
+        if (MASKS[m] & SOLAR_FIELD(f)) got[f] = solar_get(&out, MASKS[m], (SolarField)f);
+      }
+    }
+
+    for (int f = 0; f < SOLAR_FIELD_COUNT; f++) {
+      bool ok;
+      if (ref[f] < 0 || got[f] < 0) {
+        ok = ref[f] == got[f];
+      } else {
+        int d = prv_distance(ref[f], got[f]);
+        if (d > worst) worst = d;
+        ok = d <= TOLERANCE;
+        events++;
+      }
+      if (!ok) {
+        failures++;
+        printf("FAIL %.4f %.4f zone %s day %ld %s: suncalc %d, solar.c %d\n",
+               lat / 1e6, lon / 1e6, zone, day, names[f], ref[f], got[f]);
+      }
+    }
+  }
+
+  if (!lines) {
+    fprintf(stderr, "no reference input\n");
+    return 2;
+  }
+  printf("%d site-days, %d events, worst %d min, %d failures\n", lines, events, worst, failures);
+  return failures ? 1 : 0;
+}
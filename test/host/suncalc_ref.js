@@ -0,0 +1,51 @@
+// Reference times from SunCalc for solar_test. One line per site and local
+// day: lat_e6 lon_e6 zone day, then minutes since local midnight for each
+// SolarField (-1 if it does not happen). zone is a fixed offset in seconds,
+// or "watch" for the process's own zone (TZ), DST and all.
+
+var SunCalc = require('suncalc');
+
+SunCalc.addTime(-4, 'blueEnd', 'blueStart');
+
+// In SolarField order
+var NAMES = ['nightEnd', 'nauticalDawn', 'dawn', 'blueEnd', 'sunrise', 'goldenHourEnd',
+             'solarNoon', 'goldenHour', 'sunset', 'blueStart', 'dusk', 'nauticalDusk', 'night'];
+
+var SITES = [
+  { lat: 0, lon: 0, zone: 0 },                     // equator
+  { lat: 52.52, lon: 13.405, zone: 'watch' },      // Berlin, with DST
+  { lat: 40.7128, lon: -74.006, zone: -18000 },    // New York, standard time
+  { lat: -33.8688, lon: 151.2093, zone: 36000 },   // Sydney
+  { lat: 64.1466, lon: -21.9426, zone: 0 },        // Reykjavik
+  { lat: 69.6492, lon: 18.9553, zone: 3600 },      // Tromso, midnight sun
+  { lat: 78.2232, lon: 15.6267, zone: 3600 },      // Longyearbyen, polar night
+  { lat: -77.846, lon: 166.676, zone: 43200 }      // McMurdo
+];
+
+var DAY_MS = 86400000;
+var YEAR = 2026;
+
+function minutes(date, zone) {
+  var ms = date.getTime();
+  if (isNaN(ms)) return -1;
+  if (zone === 'watch') return date.getHours() * 60 + date.getMinutes();
+  var local = ms + zone * 1000;
+  return Math.floor((((local % DAY_MS) + DAY_MS) % DAY_MS) / 60000);
+}
+
+SITES.forEach(function(site) {
+  for (var i = 0; i < 365; i++) {
+    var noon, day;
+    if (site.zone === 'watch') {
+      noon = new Date(YEAR, 0, 1 + i, 12);
+      day = Math.floor((noon.getTime() - noon.getTimezoneOffset() * 60000) / DAY_MS);
+    } else {
+      day = Date.UTC(YEAR, 0, 1 + i) / DAY_MS;
+      noon = new Date(day * DAY_MS + DAY_MS / 2 - site.zone * 1000);
+    }
+    var t = SunCalc.getTimes(noon, site.lat, site.lon);
+    var line = [Math.round(site.lat * 1e6), Math.round(site.lon * 1e6), site.zone, day];
+    NAMES.forEach(function(name) { line.push(minutes(t[name], site.zone)); });
+    console.log(line.join(' '));
+  }
+});
@@ -0,0 +1,243 @@
+// Runs src/pkjs/index.js under node with Pebble, navigator.geolocation,
+// localStorage and setTimeout mocked, and replays a trace of watch requests
+// against it for a spread of sites. Per site it reports the time spent
+// building each reply, the bytes per sendAppMessage payload and the time
+// from the watch asking to the reply being acked, on a simulated clock.
+//
+//   node tools/bench-node.js [--trace FILE] [--latency MS] [--fix MS] [--proto N] [--verbose]
+//
+// FILE is a JSON array of requests as metrics.js records them (the
+// 'helios.trace' localStorage entry); without one, bench.js's synthetic
+// trace is used. The trace runs once as recorded and once as protocol 3,
+// where replies are patches against the epoch the simulated watch holds;
+// --proto N runs the one pass at that version instead. index.js needs the
+// app's npm dependencies (suncalc).
+//
+// Exits 1 on ERROR replies, unanswered requests, a reply that took longer
+// than the first fix plus a round trip (and SEND_SLACK_MS) to be acked, or
+// a patch pass that sent no patches.
+
+var path = require('path');
+var fs = require('fs');
+
+var PKJS = path.join(__dirname, '..', 'src', 'pkjs');
+var Metrics = require(path.join(PKJS, 'metrics'));
+var bench = require(path.join(PKJS, 'bench'));
+var CLASSIC = require(path.join(PKJS, 'ephemeris')).CLASSIC;
+
+// Same spread as bench.js, polar days and nights included
+var SITES = [
+  { label: 'Berlin',     lat: 52.52,  lon: 13.405 },
+  { label: 'Quito',      lat: -0.18,  lon: -78.47 },
+  { label: 'Sydney',     lat: -33.87, lon: 151.21 },
+  { label: 'Reykjavik',  lat: 64.15,  lon: -21.94 },
+  { label: 'Tromso',     lat: 69.65,  lon: 18.96 },
+  { label: 'Longyear',   lat: 78.22,  lon: 15.65 },
+  { label: 'McMurdo',    lat: -77.85, lon: 166.67 }
+];
+
+var TRACE_GAP_MS = 250;     // between synthetic requests, about msg.c's REQ_THROTTLE_MS
+var SEND_SLACK_MS = 500;    // for replies queued behind others on the cold start
+var PATCH_PROTO = 3;        // index.js's WIRE_VERSION; patches need 2 or later
+
+function parseArgs(argv) {
+  var opts = { trace: null, latency: 60, fix: 1500, proto: null, verbose: false };
+  for (var i = 2; i < argv.length; i++) {
+    var a = argv[i];
+    if (a === '--trace') opts.trace = argv[++i];
+    else if (a === '--latency') opts.latency = parseInt(argv[++i], 10);
+    else if (a === '--fix') opts.fix = parseInt(argv[++i], 10);
+    else if (a === '--proto') opts.proto = parseInt(argv[++i], 10);
+    else if (a === '--verbose') opts.verbose = true;
+    else throw new Error('unknown argument ' + a);
+  }
+  return opts;
+}
+
+function loadTrace(file, proto) {
+  var trace = file ? JSON.parse(fs.readFileSync(file, 'utf8')) : bench.syntheticTrace();
+  var at = 0;
+  return trace.map(function(r) {
+    at = typeof r.at === 'number' ? r.at : at + TRACE_GAP_MS;
+    return { at: at, center: r.center | 0, count: r.count || 3,
+             proto: proto === null ? r.proto | 0 : proto, fields: r.fields || CLASSIC };
+  });
+}
+
+// Virtual clock: timers only run when the replay lets time pass
+function Clock() {
+  this.now = 0;
+  this.queue = [];
+  this.nextId = 1;
+}
+
+Clock.prototype.setTimeout = function(fn, ms) {
+  var t = { id: this.nextId++, at: this.now + Math.max(0, ms | 0), fn: fn };
+  var i = this.queue.length;
+  while (i > 0 && this.queue[i - 1].at > t.at) i--;
+  this.queue.splice(i, 0, t);
+  return t.id;
+};
+
+Clock.prototype.clearTimeout = function(id) {
+  this.queue = this.queue.filter(function(t) { return t.id !== id; });
+};
+
+Clock.prototype.runUntil = function(at, call) {
+  while (this.queue.length && this.queue[0].at <= at) {
+    var t = this.queue.shift();
+    this.now = t.at;
+    call(t.fn);
+  }
+  if (at > this.now) this.now = at;
+};
+
+function Storage() {
+  this.items = {};
+}
+Storage.prototype.getItem = function(k) { return this.items.hasOwnProperty(k) ? this.items[k] : null; };
+Storage.prototype.setItem = function(k, v) { this.items[k] = String(v); };
+Storage.prototype.removeItem = function(k) { delete this.items[k]; };
+Storage.prototype.clear = function() { this.items = {}; };
+
+function hrMs() {
+  var t = process.hrtime();
+  return t[0] * 1000 + t[1] / 1e6;
+}
+
+// One cold start of index.js at a site, then the whole trace
+function runSite(site, trace, opts) {
+  var clock = new Clock();
+  var handlers = {};
+  var outbox = [];              // Pebble sends one message at a time
+  var sending = false;
+  var callStart = 0;            // host time the current callback started
+  var pending = {};             // seq -> virtual time the watch asked
+  var watchEpoch = 0;           // what the simulated watch echoes back
+  var result = { compute: new Metrics.Stat(), bytes: new Metrics.Stat(), toSend: new Metrics.Stat(),
+                 replies: 0, patches: 0, errors: 0, other: 0 };
+
+  function call(fn) {
+    callStart = hrMs();
+    fn();
+  }
+
+  function pump() {
+    if (sending || !outbox.length) return;
+    var m = outbox.shift();
+    sending = true;
+    clock.setTimeout(function() {
+      sending = false;
+      if (m.asked !== undefined) result.toSend.add(clock.now - m.asked + Math.round(m.compute));
+      if (m.ok) m.ok({});
+      pump();
+    }, 2 * opts.latency);
+  }
+
+  global.localStorage = new Storage();
+  global.setTimeout = clock.setTimeout.bind(clock);
+  global.clearTimeout = clock.clearTimeout.bind(clock);
+  global.navigator = {
+    geolocation: {
+      getCurrentPosition: function(ok) {
+        clock.setTimeout(function() {
+          ok({ coords: { latitude: site.lat, longitude: site.lon } });
+        }, opts.fix);
+      }
+    }
+  };
+  global.Pebble = {
+    addEventListener: function(name, fn) { handlers[name] = fn; },
+    sendAppMessage: function(msg, ok) {
+      var m = { ok: ok, compute: hrMs() - callStart };
+      if (typeof msg.SEQ === 'number' && pending.hasOwnProperty(msg.SEQ)) {
+        m.asked = pending[msg.SEQ];
+        delete pending[msg.SEQ];
+        result.replies++;
+        result.compute.add(m.compute);
+        result.bytes.add(Metrics.payloadBytes(msg));
+        if (msg.ERROR) result.errors++;
+        if (msg.PATCH) {
+          result.patches++;
+          watchEpoch = msg.PATCH[10] | (msg.PATCH[11] << 8);
+        } else if (msg.EPOCH) {
+          watchEpoch = msg.EPOCH;
+        }
+      } else {
+        result.other++;
+      }
+      outbox.push(m);
+      pump();
+    },
+    openURL: function() {}
+  };
+
+  // A fresh copy of the phone side, with its own module state
+  Object.keys(require.cache).forEach(function(k) {
+    if (k.indexOf(PKJS) === 0) delete require.cache[k];
+  });
+  var log = console.log;
+  if (!opts.verbose) console.log = function() {};
+  try {
+    require(path.join(PKJS, 'index'));
+    call(function() { handlers.ready({}); });
+    for (var i = 0; i < trace.length; i++) {
+      var r = trace[i];
+      clock.runUntil(r.at, call);
+      pending[i] = clock.now;
+      var payload = { REQ: 1, SEQ: i, OFFSET: r.center, COUNT: r.count, PROTO: r.proto,
+                      FIELDS: r.fields, EPOCH: watchEpoch };
+      call(function() { handlers.appmessage({ payload: payload }); });
+    }
+    clock.runUntil(clock.now + 60000, call);
+  } finally {
+    console.log = log;
+  }
+  result.unanswered = Object.keys(pending).length;
+  return result;
+}
+
+function fmt(stat, digits) {
+  if (!stat.n) return '-';
+  return (stat.sum / stat.n).toFixed(digits) + ' avg, ' + stat.max.toFixed(digits) + ' max';
+}
+
+// One pass over every site; returns whether it failed
+function runPass(name, trace, opts) {
+  var limit = opts.fix + 2 * opts.latency + SEND_SLACK_MS;
+  var patching = trace.some(function(r) { return r.proto >= 2; });
+  var failed = false;
+  console.log(name + ': ' + trace.length + ' requests x ' + SITES.length + ' sites, ' +
+              opts.latency + ' ms link, ' + opts.fix + ' ms first fix');
+  SITES.forEach(function(site) {
+    var r = runSite(site, trace, opts);
+    var problems = [];
+    if (r.errors) problems.push('errors');
+    if (r.unanswered) problems.push('unanswered requests');
+    if (r.toSend.n && r.toSend.max > limit) problems.push('to send over ' + limit + ' ms');
+    if (patching && !r.patches) problems.push('no patches');
+    console.log(site.label + ': ' + r.replies + ' replies (' + r.patches + ' patches, ' +
+                r.errors + ' errors, ' + r.unanswered + ' unanswered), ' + r.other + ' other sends');
+    console.log('  compute ms ' + fmt(r.compute, 2) + ' | bytes ' + fmt(r.bytes, 0) +
+                ' | to send ms ' + fmt(r.toSend, 0));
+    if (problems.length) {
+      console.log('  FAIL: ' + problems.join(', '));
+      failed = true;
+    }
+  });
+  return failed;
+}
+
+function main() {
+  var opts = parseArgs(process.argv);
+  var failed;
+  if (opts.proto !== null) {
+    failed = runPass('protocol ' + opts.proto, loadTrace(opts.trace, opts.proto), opts);
+  } else {
+    failed = runPass('as recorded', loadTrace(opts.trace, null), opts);
+    failed = runPass('protocol ' + PATCH_PROTO, loadTrace(opts.trace, PATCH_PROTO), opts) || failed;
+  }
+  process.exitCode = failed ? 1 : 0;
+}
+
+main();
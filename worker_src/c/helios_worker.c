@@ -0,0 +1,32 @@
+#include <pebble_worker.h>
+#include "refresh.h"
+
+// Background worker: keeps the persisted week of solar times current so the
+// app can paint straight from flash. It wakes once a day and when the app
+// reports a new location; each run is at most REFRESH_DAYS integer solves.
+
+static void prv_day_changed(struct tm *tick_time, TimeUnits units_changed) {
+  refresh_store(REFRESH_MIDNIGHT, false);
+}
+
+static void prv_app_message(uint16_t type, AppWorkerMessage *data) {
+  if (type == WORKER_MSG_REFRESH) refresh_store(REFRESH_LOCATION, true);
+  else if (type == WORKER_MSG_EXTEND) refresh_store(REFRESH_APP_EXIT, false);
+}
+
+static void prv_init(void) {
+  refresh_store(REFRESH_START, false);
+  tick_timer_service_subscribe(DAY_UNIT, prv_day_changed);
+  app_worker_message_subscribe(prv_app_message);
+}
+
+static void prv_deinit(void) {
+  app_worker_message_unsubscribe();
+  tick_timer_service_unsubscribe();
+}
+
+int main(void) {
+  prv_init();
+  worker_event_loop();
+  prv_deinit();
+}